@@ -9,6 +9,7 @@
 
 #include "zeek/Desc.h"
 #include "zeek/Event.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/NetVar.h"
 #include "zeek/Reporter.h"
 #include "zeek/RunState.h"
@@ -71,6 +72,7 @@ Connection::Connection(const detail::ConnKey& k, double t, const ConnTuple* id,
 
     ++current_connections;
     ++total_connections;
+    detail::memory_allocated(detail::MemoryTag::Connection, sizeof(Connection));
 
     encapsulation = pkt->encap;
 }
@@ -87,6 +89,7 @@ Connection::~Connection() {
     delete adapter;
 
     --current_connections;
+    detail::memory_freed(detail::MemoryTag::Connection, sizeof(Connection));
 }
 
 void Connection::CheckEncapsulation(const std::shared_ptr<EncapsulationStack>& arg_encap) {
@@ -92,8 +92,8 @@ void ODesc::Add(int i) {
     if ( IsBinary() )
         AddBytes(&i, sizeof(i));
     else {
-        char tmp[256];
-        modp_litoa10(i, tmp);
+        char tmp[util::NUMBER_BUFFER_SIZE];
+        util::format_int(i, tmp);
         Add(tmp);
     }
 }
@@ -102,8 +102,8 @@ void ODesc::Add(uint32_t u) {
     if ( IsBinary() )
         AddBytes(&u, sizeof(u));
     else {
-        char tmp[256];
-        modp_ulitoa10(u, tmp);
+        char tmp[util::NUMBER_BUFFER_SIZE];
+        util::format_uint(u, tmp);
         Add(tmp);
     }
 }
@@ -112,8 +112,8 @@ void ODesc::Add(int64_t i) {
     if ( IsBinary() )
         AddBytes(&i, sizeof(i));
     else {
-        char tmp[256];
-        modp_litoa10(i, tmp);
+        char tmp[util::NUMBER_BUFFER_SIZE];
+        util::format_int(i, tmp);
         Add(tmp);
     }
 }
@@ -122,8 +122,8 @@ void ODesc::Add(uint64_t u) {
     if ( IsBinary() )
         AddBytes(&u, sizeof(u));
     else {
-        char tmp[256];
-        modp_ulitoa10(u, tmp);
+        char tmp[util::NUMBER_BUFFER_SIZE];
+        util::format_uint(u, tmp);
         Add(tmp);
     }
 }
@@ -135,15 +135,19 @@ void ODesc::Add(double d, bool no_exp) {
         // Buffer needs enough chars to store max. possible "double" value
         // of 1.79e308 without using scientific notation.
         char tmp[350];
+        size_t n;
 
         if ( no_exp )
-            modp_dtoa3(d, tmp, sizeof(tmp), IsReadable() ? 6 : 8);
+            n = modp_dtoa3(d, tmp, sizeof(tmp), IsReadable() ? 6 : 8);
         else
-            modp_dtoa2(d, tmp, IsReadable() ? 6 : 8);
+            n = modp_dtoa2(d, tmp, IsReadable() ? 6 : 8);
 
-        Add(tmp);
+        if ( IsReadable() && offset > 0 && ((const char*)base)[offset - 1] == '\n' )
+            Indent();
+
+        AddBytes(tmp, n);
 
-        if ( util::approx_equal(d, nearbyint(d), 1e-9) && std::isfinite(d) && ! strchr(tmp, 'e') )
+        if ( util::approx_equal(d, nearbyint(d), 1e-9) && std::isfinite(d) && ! memchr(tmp, 'e', n) )
             // disambiguate from integer
             Add(".0");
     }
@@ -6,6 +6,7 @@
 
 #include "zeek/Desc.h"
 #include "zeek/Func.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/NetVar.h"
 #include "zeek/Trigger.h"
 #include "zeek/Val.h"
@@ -28,8 +29,12 @@ Event::Event(const EventHandlerPtr& arg_handler, zeek::Args arg_args, util::deta
       next_event(nullptr) {
     if ( obj )
         Ref(obj);
+
+    detail::memory_allocated(detail::MemoryTag::Event, sizeof(Event) + args.size() * sizeof(ValPtr));
 }
 
+Event::~Event() { detail::memory_freed(detail::MemoryTag::Event, sizeof(Event) + args.size() * sizeof(ValPtr)); }
+
 void Event::Describe(ODesc* d) const {
     if ( d->IsReadable() )
         d->AddSP("event");
@@ -25,6 +25,8 @@ public:
     Event(const EventHandlerPtr& handler, zeek::Args args, util::detail::SourceID src = util::detail::SOURCE_LOCAL,
           analyzer::ID aid = 0, Obj* obj = nullptr, double ts = run_state::network_time);
 
+    ~Event() override;
+
     void SetNext(Event* n) { next_event = n; }
     Event* NextEvent() const { return next_event; }
 
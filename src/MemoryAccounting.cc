@@ -0,0 +1,149 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/MemoryAccounting.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "zeek/3rdparty/doctest.h"
+#include "zeek/telemetry/Manager.h"
+
+namespace zeek::detail {
+
+thread_local ThreadMemoryCounts* thread_memory_counts = nullptr;
+
+namespace {
+
+// Counters of all threads. They are never freed: when a thread exits, its
+// counters get handed to the next thread that starts reporting, so the
+// sums remain correct.
+struct CountsRegistry {
+    std::mutex mtx;
+    std::vector<ThreadMemoryCounts*> all;
+    std::vector<ThreadMemoryCounts*> unused;
+};
+
+// Deliberately leaked so that it's usable during static initialization
+// and destruction.
+CountsRegistry& registry() {
+    static auto* r = new CountsRegistry();
+    return *r;
+}
+
+// Updated with atomic additions by threads that report while exiting,
+// after their counters have already been handed back.
+ThreadMemoryCounts exiting_counts;
+thread_local bool thread_exiting = false;
+
+// Hands a thread's counters back when the thread exits.
+struct ThreadCountsRelease {
+    ~ThreadCountsRelease() {
+        thread_exiting = true;
+
+        if ( ! thread_memory_counts )
+            return;
+
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mtx);
+        r.unused.push_back(thread_memory_counts);
+        thread_memory_counts = nullptr;
+    }
+};
+
+} // namespace
+
+const char* memory_tag_name(MemoryTag tag) {
+    switch ( tag ) {
+        case MemoryTag::Connection: return "connection";
+        case MemoryTag::Reassembly: return "reassembly";
+        case MemoryTag::Table: return "table";
+        case MemoryTag::Event: return "event";
+        case MemoryTag::LogBuffer: return "log_buffer";
+        case MemoryTag::FileAnalysis: return "file_analysis";
+        case MemoryTag::NumTags: break;
+    }
+
+    return "unknown";
+}
+
+void memory_adjust_slow(MemoryTag tag, int64_t n) {
+    auto idx = static_cast<size_t>(tag);
+
+    if ( thread_exiting ) {
+        exiting_counts.bytes[idx].fetch_add(n, std::memory_order_relaxed);
+        return;
+    }
+
+    static thread_local ThreadCountsRelease release;
+
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mtx);
+
+        if ( ! r.unused.empty() ) {
+            thread_memory_counts = r.unused.back();
+            r.unused.pop_back();
+        }
+        else {
+            thread_memory_counts = new ThreadMemoryCounts();
+            r.all.push_back(thread_memory_counts);
+        }
+    }
+
+    auto& b = thread_memory_counts->bytes[idx];
+    b.store(b.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+int64_t memory_live_bytes(MemoryTag tag) {
+    auto idx = static_cast<size_t>(tag);
+    int64_t sum = exiting_counts.bytes[idx].load(std::memory_order_relaxed);
+
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    for ( const auto* counts : r.all )
+        sum += counts->bytes[idx].load(std::memory_order_relaxed);
+
+    return sum;
+}
+
+void init_memory_accounting_metrics() {
+    auto family = telemetry_mgr->GaugeFamily("zeek", "memory_subsystem", {"subsystem"},
+                                             "Bytes currently allocated by a subsystem, as reported by its "
+                                             "allocation sites",
+                                             "bytes");
+
+    for ( size_t i = 0; i < NUM_MEMORY_TAGS; i++ ) {
+        auto tag = static_cast<MemoryTag>(i);
+        family->GetOrAdd({{"subsystem", memory_tag_name(tag)}},
+                         [tag]() { return static_cast<double>(memory_live_bytes(tag)); });
+    }
+}
+
+} // namespace zeek::detail
+
+// -- unit tests ---------------------------------------------------------------
+
+TEST_CASE("memory accounting sums up across threads") {
+    using namespace zeek::detail;
+
+    auto before = memory_live_bytes(MemoryTag::Event);
+
+    memory_allocated(MemoryTag::Event, 100);
+    CHECK_EQ(memory_live_bytes(MemoryTag::Event), before + 100);
+
+    // Memory freed by a different thread than the one allocating it.
+    std::thread t([]() {
+        memory_allocated(MemoryTag::Event, 50);
+        memory_freed(MemoryTag::Event, 100);
+    });
+    t.join();
+
+    CHECK_EQ(memory_live_bytes(MemoryTag::Event), before + 50);
+
+    // A new thread picks up the counters of the exited one.
+    std::thread t2([]() { memory_freed(MemoryTag::Event, 50); });
+    t2.join();
+
+    CHECK_EQ(memory_live_bytes(MemoryTag::Event), before);
+}
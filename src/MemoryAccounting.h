@@ -0,0 +1,99 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Tagged accounting of the live bytes allocated by Zeek's major subsystems.
+//
+// Allocation sites report the sizes of the objects they create and destroy
+// under a tag identifying the subsystem. Each thread accumulates these in
+// counters of its own using plain loads and stores, so reporting costs about
+// as much as incrementing an integer. The per-subsystem totals get summed up
+// only when they are requested, in particular when telemetry gets collected.
+//
+// The numbers are an approximation: they cover the objects themselves and
+// the buffers they own directly, not what the system allocator adds on top.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace zeek::detail {
+
+enum class MemoryTag : uint8_t {
+    Connection,   // Connection objects.
+    Reassembly,   // Reassembler data blocks.
+    Table,        // Entries of script-level tables and sets.
+    Event,        // Queued events.
+    LogBuffer,    // Log records buffered by writer frontends.
+    FileAnalysis, // File objects and their beginning-of-file buffers.
+    NumTags,
+};
+
+constexpr size_t NUM_MEMORY_TAGS = static_cast<size_t>(MemoryTag::NumTags);
+
+/**
+ * @return The name of the subsystem a tag stands for, as used for the
+ * telemetry label.
+ */
+const char* memory_tag_name(MemoryTag tag);
+
+/**
+ * The live bytes a single thread reported, indexed by tag. The values can
+ * be negative when memory gets freed by a different thread than the one
+ * that allocated it.
+ */
+struct alignas(64) ThreadMemoryCounts {
+    std::atomic<int64_t> bytes[NUM_MEMORY_TAGS] = {};
+};
+
+/**
+ * The calling thread's counters, or null if it hasn't reported anything
+ * yet.
+ */
+extern thread_local ThreadMemoryCounts* thread_memory_counts;
+
+/**
+ * Adds @p n bytes to tag's total from a thread that doesn't have counters
+ * yet. Internal, use memory_allocated() or memory_freed().
+ */
+void memory_adjust_slow(MemoryTag tag, int64_t n);
+
+/**
+ * Records the allocation of @p n bytes for the subsystem @p tag.
+ */
+inline void memory_allocated(MemoryTag tag, size_t n) noexcept {
+    if ( auto* counts = thread_memory_counts ) {
+        // Only this thread writes its counters, so no read-modify-write is
+        // needed. The atomics just make the reads by other threads safe.
+        auto& b = counts->bytes[static_cast<size_t>(tag)];
+        b.store(b.load(std::memory_order_relaxed) + static_cast<int64_t>(n), std::memory_order_relaxed);
+    }
+    else
+        memory_adjust_slow(tag, static_cast<int64_t>(n));
+}
+
+/**
+ * Records that @p n bytes of the subsystem @p tag have been freed.
+ */
+inline void memory_freed(MemoryTag tag, size_t n) noexcept {
+    if ( auto* counts = thread_memory_counts ) {
+        auto& b = counts->bytes[static_cast<size_t>(tag)];
+        b.store(b.load(std::memory_order_relaxed) - static_cast<int64_t>(n), std::memory_order_relaxed);
+    }
+    else
+        memory_adjust_slow(tag, -static_cast<int64_t>(n));
+}
+
+/**
+ * @return The number of bytes currently allocated for the subsystem @p tag,
+ * summed up across all threads.
+ */
+int64_t memory_live_bytes(MemoryTag tag);
+
+/**
+ * Registers the telemetry gauges exporting the per-subsystem byte counts.
+ * Must be called after the telemetry manager has been initialized.
+ */
+void init_memory_accounting_metrics();
+
+} // namespace zeek::detail
@@ -85,6 +85,7 @@ extern int dpd_max_packets;
 extern int dpd_match_only_beginning;
 extern int dpd_late_match_stop;
 extern int dpd_ignore_ports;
+extern int dpd_fast_classifier;
 
 extern int record_all_packets;
 
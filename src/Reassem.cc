@@ -8,6 +8,7 @@
 #include <limits>
 
 #include "zeek/Desc.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/Reporter.h"
 
 using std::min;
@@ -50,6 +51,7 @@ void DataBlockList::Delete(DataBlockMap::const_iterator it) {
 
     Reassembler::total_size -= size + sizeof(DataBlock);
     Reassembler::sizes[reassembler->rtype] -= size + sizeof(DataBlock);
+    detail::memory_freed(detail::MemoryTag::Reassembly, size + sizeof(DataBlock));
 }
 
 DataBlock DataBlockList::Remove(DataBlockMap::const_iterator it) {
@@ -67,6 +69,7 @@ void DataBlockList::Clear() {
     auto total = total_data_size + total_db_size;
     Reassembler::total_size -= total;
     Reassembler::sizes[reassembler->rtype] -= total;
+    detail::memory_freed(detail::MemoryTag::Reassembly, total);
     total_data_size = 0;
     block_map.clear();
 }
@@ -101,6 +104,7 @@ DataBlockMap::const_iterator DataBlockList::Insert(uint64_t seq, uint64_t upper,
     total_data_size += size;
     Reassembler::sizes[reassembler->rtype] += size + sizeof(DataBlock);
     Reassembler::total_size += size + sizeof(DataBlock);
+    detail::memory_allocated(detail::MemoryTag::Reassembly, size + sizeof(DataBlock));
 
     return rval;
 }
@@ -4,10 +4,12 @@
 #include "zeek/zeek-config.h"
 
 #include <algorithm>
+#include <bitset>
 #include <functional>
 
 #include "zeek/DFA.h"
 #include "zeek/DebugLogger.h"
+#include "zeek/EquivClass.h"
 #include "zeek/File.h"
 #include "zeek/ID.h"
 #include "zeek/IP.h"
@@ -332,6 +334,7 @@ bool RuleMatcher::ReadFiles(const std::vector<SignatureFile>& files) {
     string_list exprs[Rule::TYPES];
     int_list ids[Rule::TYPES];
     BuildRegEx(root, exprs, ids);
+    BuildFileMagicIndex();
 
     return ! parse_error;
 }
@@ -366,6 +369,11 @@ void RuleMatcher::BuildRulesTree() {
                 has_non_file_magic_rule = true;
         }
 
+        for ( const auto& act : rule->actions ) {
+            if ( auto* enable = dynamic_cast<RuleActionEnable*>(act); enable && enable->Analyzer() )
+                enabled_analyzers.insert(enable->Analyzer());
+        }
+
         rule->SortHdrTests();
         InsertRuleIntoTree(rule, 0, root, 0);
     }
@@ -485,6 +493,138 @@ void RuleMatcher::BuildPatternSets(RuleHdrTest::pattern_set_list* dst, const str
     }
 }
 
+// File magic patterns that may start with more than this many different
+// bytes aren't worth indexing and go into the common sets instead.
+static constexpr size_t MAX_MAGIC_FIRST_BYTES = 32;
+
+// Determines the bytes a file magic pattern can match first, based on the
+// pattern's own DFA. Returns false if that's not a useful criterion, i.e.,
+// if the pattern can match before seeing any data.
+static bool magic_first_bytes(char* pattern, int id, std::bitset<256>* bytes) {
+    Specific_RE_Matcher re(MATCH_EXACTLY, true);
+    string_list exprs;
+    int_list ids;
+    exprs.push_back(pattern);
+    ids.push_back(id);
+
+    if ( ! re.CompileSet(exprs, ids) || ! re.DFA() )
+        return false;
+
+    auto* dfa = re.DFA();
+    const int* ecs = re.EC()->EquivClasses();
+
+    // RuleMatcher::Match() always feeds the beginning-of-line symbol first.
+    DFA_State* d = dfa->StartState();
+
+    if ( d->Accept() )
+        return false;
+
+    d = d->Xtion(ecs[SYM_BOL], dfa);
+
+    if ( ! d || d->Accept() )
+        return false;
+
+    std::map<int, bool> live; // by equivalence class
+
+    for ( int c = 0; c < 256; ++c ) {
+        auto [it, inserted] = live.emplace(ecs[c], false);
+
+        if ( inserted )
+            it->second = d->Xtion(ecs[c], dfa) != nullptr;
+
+        if ( it->second )
+            bytes->set(c);
+    }
+
+    return true;
+}
+
+void RuleMatcher::BuildFileMagicIndex() {
+    auto& psets = root->psets[Rule::FILE_MAGIC];
+
+    magic_common = 0;
+    magic_index.clear();
+
+    string_list exprs;
+    int_list ids;
+
+    for ( const auto& set : psets ) {
+        loop_over_list(set->patterns, i) {
+            exprs.push_back(set->patterns[i]);
+            ids.push_back(set->ids[i]);
+        }
+    }
+
+    if ( exprs.empty() )
+        return;
+
+    string_list common_exprs;
+    int_list common_ids;
+    std::vector<int> candidates[256]; // indices into exprs by first byte
+
+    loop_over_list(exprs, i) {
+        std::bitset<256> bytes;
+
+        if ( ! magic_first_bytes(exprs[i], ids[i], &bytes) || bytes.count() > MAX_MAGIC_FIRST_BYTES ) {
+            common_exprs.push_back(exprs[i]);
+            common_ids.push_back(ids[i]);
+            continue;
+        }
+
+        for ( int c = 0; c < 256; ++c )
+            if ( bytes.test(c) )
+                candidates[c].push_back(i);
+    }
+
+    for ( auto set : psets ) {
+        delete set->re;
+        delete set;
+    }
+
+    psets.clear();
+
+    if ( common_exprs.length() )
+        BuildPatternSets(&psets, common_exprs, common_ids);
+
+    magic_common = psets.length();
+    magic_index.resize(256);
+
+    // Bytes with the same candidates share their pattern sets.
+    std::map<std::vector<int>, std::vector<int>> sets_by_candidates;
+
+    for ( int c = 0; c < 256; ++c ) {
+        if ( candidates[c].empty() )
+            continue;
+
+        auto it = sets_by_candidates.find(candidates[c]);
+
+        if ( it == sets_by_candidates.end() ) {
+            string_list group_exprs;
+            int_list group_ids;
+
+            for ( auto i : candidates[c] ) {
+                group_exprs.push_back(exprs[i]);
+                group_ids.push_back(ids[i]);
+            }
+
+            int first = psets.length();
+            BuildPatternSets(&psets, group_exprs, group_ids);
+
+            std::vector<int> set_indices;
+
+            for ( int j = first; j < psets.length(); ++j )
+                set_indices.push_back(j);
+
+            it = sets_by_candidates.emplace(candidates[c], std::move(set_indices)).first;
+        }
+
+        magic_index[c] = it->second;
+    }
+
+    DBG_LOG(DBG_RULES, "Indexed %d file magic patterns, %d in %d common sets", exprs.length(), common_exprs.length(),
+            magic_common);
+}
+
 // Get a 8/16/32-bit value from the given position in the packet header
 static inline uint32_t getval(const u_char* data, int size) {
     switch ( size ) {
@@ -640,9 +780,24 @@ RuleMatcher::MIME_Matches* RuleMatcher::Match(RuleFileMagicState* state, const u
 
     bool newmatch = false;
 
-    for ( const auto& m : state->matchers ) {
+    auto match = [&](RuleFileMagicState::Matcher* m) {
         if ( m->state->Match(data, len, true, false, true) )
             newmatch = true;
+    };
+
+    if ( magic_index.empty() ) {
+        for ( const auto& m : state->matchers )
+            match(m);
+    }
+    else {
+        // Patterns outside of the common sets can only match if the
+        // first byte selects them.
+        for ( int i = 0; i < magic_common; ++i )
+            match(state->matchers[i]);
+
+        if ( len > 0 )
+            for ( auto i : magic_index[data[0]] )
+                match(state->matchers[i]);
     }
 
     if ( ! newmatch )
@@ -11,6 +11,7 @@
 #include "zeek/CCL.h"
 #include "zeek/RE.h"
 #include "zeek/Rule.h"
+#include "zeek/Tag.h"
 #include "zeek/ScannedFile.h"
 #include "zeek/ZeekString.h"
 #include "zeek/plugin/Manager.h"
@@ -317,6 +318,9 @@ public:
 
     bool HasNonFileMagicRule() const { return has_non_file_magic_rule; }
 
+    // Returns true if a loaded signature enables the given analyzer.
+    bool HasEnableRule(const zeek::Tag& analyzer) const { return enabled_analyzers.count(analyzer) > 0; }
+
     // Interface to for getting some statistics
     struct Stats {
         unsigned int matchers; // # distinct RE matchers
@@ -355,6 +359,9 @@ private:
     // Build groups of regular expressions.
     void BuildPatternSets(RuleHdrTest::pattern_set_list* dst, const string_list& exprs, const int_list& ids);
 
+    // Regroup the file magic patterns by the first byte they can match.
+    void BuildFileMagicIndex();
+
     // Check an arbitrary rule if it's satisfied right now.
     // eos signals end of stream
     void ExecRule(Rule* rule, RuleEndpointState* state, bool eos);
@@ -381,10 +388,17 @@ private:
 
     int RE_level;
     bool has_non_file_magic_rule;
+    std::set<zeek::Tag> enabled_analyzers; // Analyzers that active rules enable.
     bool parse_error;
     RuleHdrTest* root;
     rule_list rules;
     rule_dict rules_by_id;
+
+    // The file magic pattern sets on the root node start with
+    // magic_common sets that run on all data. The remaining sets only
+    // run on data whose first byte selects them through magic_index.
+    int magic_common = 0;
+    std::vector<std::vector<int>> magic_index;
 };
 
 // Keeps bi-directional matching-state.
@@ -37,6 +37,7 @@ extern "C" {
 #include "zeek/packet_analysis/Manager.h"
 #include "zeek/plugin/Manager.h"
 #include "zeek/session/Manager.h"
+#include "zeek/supervisor/Supervisor.h"
 
 static double last_watchdog_proc_time = 0.0; // value of above during last watchdog
 extern int signal_val;
@@ -238,6 +239,9 @@ void dispatch_packet(Packet* pkt, iosource::PktSrc* pkt_src) {
 
         if ( network_time_init )
             event_mgr.Enqueue(network_time_init, Args{});
+
+        if ( const auto& node = Supervisor::ThisNode() )
+            node->ObserveFirstPacket();
     }
 
     current_iosrc = pkt_src;
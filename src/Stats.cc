@@ -10,6 +10,7 @@
 #include "zeek/File.h"
 #include "zeek/Func.h"
 #include "zeek/ID.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/NetVar.h"
 #include "zeek/RuleMatcher.h"
 #include "zeek/RunState.h"
@@ -113,6 +114,13 @@ void ProfileLogger::Log() {
     file->Write(util::fmt("%.06f Memory: total=%" PRId64 "K total_adj=%" PRId64 "K malloced: %" PRId64 "K\n",
                           run_state::network_time, total / 1024, (total - first_total) / 1024, malloced / 1024));
 
+    file->Write(util::fmt("%.06f Memory by subsystem:", run_state::network_time));
+    for ( size_t i = 0; i < NUM_MEMORY_TAGS; i++ ) {
+        auto tag = static_cast<MemoryTag>(i);
+        file->Write(util::fmt(" %s=%" PRId64 "K", memory_tag_name(tag), memory_live_bytes(tag) / 1024));
+    }
+    file->Write("\n");
+
     file->Write(util::fmt("%.06f Run-time: user+sys=%.1f user=%.1f sys=%.1f real=%.1f\n", run_state::network_time,
                           (utime + stime) - (first_utime + first_stime), utime - first_utime, stime - first_stime,
                           rtime - first_rtime));
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "zeek/IntrusivePtr.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/Notifier.h"
 #include "zeek/Reporter.h"
 #include "zeek/Timer.h"
@@ -712,8 +713,14 @@ class TableEntryVal {
 public:
     explicit TableEntryVal(ValPtr v) : val(std::move(v)) {
         expire_access_time = int(run_state::network_time - run_state::zeek_start_network_time);
+        detail::memory_allocated(detail::MemoryTag::Table, sizeof(TableEntryVal));
     }
 
+    TableEntryVal(const TableEntryVal&) = delete;
+    TableEntryVal& operator=(const TableEntryVal&) = delete;
+
+    ~TableEntryVal() { detail::memory_freed(detail::MemoryTag::Table, sizeof(TableEntryVal)); }
+
     TableEntryVal* Clone(Val::CloneState* state);
 
     const ValPtr& GetVal() const { return val; }
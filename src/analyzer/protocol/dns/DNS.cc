@@ -57,6 +57,10 @@ void DNS_Interpreter::ParseMessage(const u_char* data, int len, int is_query) {
 
     detail::DNS_MsgInfo msg(hdr, is_query);
 
+    name_cache.clear();
+    name_arena.clear();
+    name_anomalies = 0;
+
     if ( first_message && msg.QR && is_query == 1 ) {
         is_query = msg.is_query = 0;
 
@@ -220,7 +224,7 @@ bool DNS_Interpreter::ParseAnswer(detail::DNS_MsgInfo* msg, const u_char*& data,
     // Note that the exact meaning of some of these fields will be
     // re-interpreted by other, more adventurous RR types.
 
-    msg->query_name = make_intrusive<StringVal>(new String(name, name_end - name, true));
+    msg->SetQueryName(name, name_end - name);
     msg->atype = detail::RR_Type(ExtractShort(data, len));
     msg->aclass = ExtractShort(data, len);
     msg->ttl = ExtractLong(data, len);
@@ -316,6 +320,9 @@ bool DNS_Interpreter::ParseAnswer(detail::DNS_MsgInfo* msg, const u_char*& data,
             break;
     }
 
+    // The name buffer goes out of scope now.
+    msg->SetQueryName(nullptr, 0);
+
     return status;
 }
 
@@ -328,8 +335,10 @@ u_char* DNS_Interpreter::ExtractName(const u_char*& data, int& len, u_char* name
 
     int n = name - name_start;
 
-    if ( n >= 255 )
+    if ( n >= 255 ) {
         analyzer->Weird("DNS_NAME_too_long");
+        ++name_anomalies;
+    }
 
     if ( n >= 2 && name[-1] == '.' ) {
         // Remove trailing dot.
@@ -348,8 +357,10 @@ u_char* DNS_Interpreter::ExtractName(const u_char*& data, int& len, u_char* name
 
 bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name, int& name_len,
                                    const u_char* msg_start) {
-    if ( len <= 0 )
+    if ( len <= 0 ) {
+        ++name_anomalies;
         return false;
+    }
 
     const u_char* orig_data = data;
     int label_len = data[0];
@@ -357,8 +368,10 @@ bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name,
     ++data;
     --len;
 
-    if ( len <= 0 )
+    if ( len <= 0 ) {
+        ++name_anomalies;
         return false;
+    }
 
     if ( label_len == 0 )
         // Found terminating label.
@@ -382,15 +395,31 @@ bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name,
             //  sometimes compression points to compression.)
 
             analyzer->Weird("DNS_label_forward_compress_offset");
+            ++name_anomalies;
             return false;
         }
 
-        // Recursively resolve name.
         const u_char* recurse_data = msg_start + offset;
         int recurse_max_len = orig_data - recurse_data;
 
+        // Many RRs in a message point at the same few names, so reuse
+        // the result of an earlier decompression where we can.
+        if ( const auto* cached = LookupName(offset, recurse_max_len, name_len) ) {
+            memcpy(name, name_arena.data() + cached->arena_offset, cached->len);
+            name += cached->len;
+            name_len -= cached->len;
+            return false;
+        }
+
+        // Recursively resolve name.
+        auto anomalies = name_anomalies;
         u_char* name_end = ExtractName(recurse_data, recurse_max_len, name, name_len, msg_start);
 
+        // Only names that decompressed cleanly get cached, so that a cache
+        // hit never suppresses a weird the recursion would have reported.
+        if ( name_anomalies == anomalies )
+            CacheName(offset, recurse_data - (msg_start + offset), name, name_end - name);
+
         name_len -= name_end - name;
         name = name_end;
 
@@ -401,6 +430,7 @@ bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name,
         analyzer->Weird("DNS_label_len_gt_pkt");
         data += len; // consume the rest of the packet
         len = 0;
+        ++name_anomalies;
         return false;
     }
 
@@ -408,11 +438,13 @@ bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name,
          // NetBIOS name service look ups can use longer labels.
          ntohs(analyzer->Conn()->RespPort()) != NETBIOS_PORT ) {
         analyzer->Weird("DNS_label_too_long");
+        ++name_anomalies;
         return false;
     }
 
     if ( label_len >= name_len ) {
         analyzer->Weird("DNS_label_len_gt_name_len");
+        ++name_anomalies;
         return false;
     }
 
@@ -428,6 +460,40 @@ bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name,
     return true;
 }
 
+const DNS_Interpreter::CachedName* DNS_Interpreter::LookupName(uint16_t offset, int max_len, int name_len) const {
+    for ( const auto& c : name_cache ) {
+        if ( c.offset != offset )
+            continue;
+
+        // The cached result is only what a recursive decompression would
+        // produce if that one could read the same bytes and had enough room
+        // for the name (plus the trailing dot it strips).
+        if ( c.consumed >= max_len || c.len + 1 >= name_len )
+            return nullptr;
+
+        return &c;
+    }
+
+    return nullptr;
+}
+
+void DNS_Interpreter::CacheName(uint16_t offset, int consumed, const u_char* name, int len) {
+    // Bound the per-message work in the face of crafted messages.
+    constexpr size_t max_cached_names = 64;
+
+    if ( name_cache.size() >= max_cached_names )
+        return;
+
+    CachedName c;
+    c.offset = offset;
+    c.consumed = consumed;
+    c.arena_offset = name_arena.size();
+    c.len = len;
+
+    name_arena.insert(name_arena.end(), name, name + len);
+    name_cache.push_back(c);
+}
+
 uint16_t DNS_Interpreter::ExtractShort(const u_char*& data, int& len) {
     if ( len < 2 )
         return 0;
@@ -1620,6 +1686,19 @@ DNS_MsgInfo::DNS_MsgInfo(DNS_RawMsgHdr* hdr, int arg_is_query) {
     skip_event = 0;
 }
 
+const StringValPtr& DNS_MsgInfo::QueryName() {
+    if ( ! query_name )
+        query_name = make_intrusive<StringVal>(query_name_len, reinterpret_cast<const char*>(query_name_data));
+
+    return query_name;
+}
+
+void DNS_MsgInfo::SetQueryName(const u_char* name, int len) {
+    query_name_data = name;
+    query_name_len = len;
+    query_name = nullptr;
+}
+
 RecordValPtr DNS_MsgInfo::BuildHdrVal() {
     static auto dns_msg = id::find_type<RecordType>("dns_msg");
     auto r = make_intrusive<RecordVal>(dns_msg);
@@ -1648,7 +1727,7 @@ RecordValPtr DNS_MsgInfo::BuildAnswerVal() {
     auto r = make_intrusive<RecordVal>(dns_answer);
 
     r->Assign(0, answer_type);
-    r->Assign(1, query_name);
+    r->Assign(1, QueryName());
     r->Assign(2, atype);
     r->Assign(3, aclass);
     r->AssignInterval(4, double(ttl));
@@ -1662,7 +1741,7 @@ RecordValPtr DNS_MsgInfo::BuildEDNS_Val() {
     static auto dns_edns_additional = id::find_type<RecordType>("dns_edns_additional");
     auto r = make_intrusive<RecordVal>(dns_edns_additional);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
 
     // type = 0x29 or 41 = EDNS
@@ -1729,7 +1808,7 @@ RecordValPtr DNS_MsgInfo::BuildTKEY_Val(struct TKEY_DATA* tkey) {
     static auto dns_tkey = id::find_type<RecordType>("dns_tkey");
     auto r = make_intrusive<RecordVal>(dns_tkey);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, tkey->alg_name);
     r->AssignTime(3, static_cast<double>(tkey->inception));
@@ -1748,7 +1827,7 @@ RecordValPtr DNS_MsgInfo::BuildTSIG_Val(struct TSIG_DATA* tsig) {
     double rtime = tsig->time_s + tsig->time_ms / 1000.0;
 
     // r->Assign(0, answer_type);
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, tsig->alg_name);
     r->Assign(3, tsig->sig);
@@ -1765,7 +1844,7 @@ RecordValPtr DNS_MsgInfo::BuildRRSIG_Val(RRSIG_DATA* rrsig) {
     static auto dns_rrsig_rr = id::find_type<RecordType>("dns_rrsig_rr");
     auto r = make_intrusive<RecordVal>(dns_rrsig_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, rrsig->type_covered);
     r->Assign(3, rrsig->algorithm);
@@ -1785,7 +1864,7 @@ RecordValPtr DNS_MsgInfo::BuildDNSKEY_Val(DNSKEY_DATA* dnskey) {
     static auto dns_dnskey_rr = id::find_type<RecordType>("dns_dnskey_rr");
     auto r = make_intrusive<RecordVal>(dns_dnskey_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, dnskey->dflags);
     r->Assign(3, dnskey->dprotocol);
@@ -1800,7 +1879,7 @@ RecordValPtr DNS_MsgInfo::BuildNSEC3_Val(NSEC3_DATA* nsec3) {
     static auto dns_nsec3_rr = id::find_type<RecordType>("dns_nsec3_rr");
     auto r = make_intrusive<RecordVal>(dns_nsec3_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, nsec3->nsec_flags);
     r->Assign(3, nsec3->nsec_hash_algo);
@@ -1819,7 +1898,7 @@ RecordValPtr DNS_MsgInfo::BuildNSEC3PARAM_Val(NSEC3PARAM_DATA* nsec3param) {
     static auto dns_nsec3param_rr = id::find_type<RecordType>("dns_nsec3param_rr");
     auto r = make_intrusive<RecordVal>(dns_nsec3param_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, nsec3param->nsec_flags);
     r->Assign(3, nsec3param->nsec_hash_algo);
@@ -1835,7 +1914,7 @@ RecordValPtr DNS_MsgInfo::BuildDS_Val(DS_DATA* ds) {
     static auto dns_ds_rr = id::find_type<RecordType>("dns_ds_rr");
     auto r = make_intrusive<RecordVal>(dns_ds_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, ds->key_tag);
     r->Assign(3, ds->algorithm);
@@ -1850,7 +1929,7 @@ RecordValPtr DNS_MsgInfo::BuildBINDS_Val(BINDS_DATA* binds) {
     static auto dns_binds_rr = id::find_type<RecordType>("dns_binds_rr");
     auto r = make_intrusive<RecordVal>(dns_binds_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, binds->algorithm);
     r->Assign(3, binds->key_id);
@@ -1865,7 +1944,7 @@ RecordValPtr DNS_MsgInfo::BuildLOC_Val(LOC_DATA* loc) {
     static auto dns_loc_rr = id::find_type<RecordType>("dns_loc_rr");
     auto r = make_intrusive<RecordVal>(dns_loc_rr);
 
-    r->Assign(0, query_name);
+    r->Assign(0, QueryName());
     r->Assign(1, answer_type);
     r->Assign(2, loc->version);
     r->Assign(3, loc->size);
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "zeek/analyzer/protocol/tcp/TCP.h"
 #include "zeek/binpac_zeek.h"
 
@@ -298,6 +300,12 @@ public:
     RecordValPtr BuildLOC_Val(struct LOC_DATA*);
     RecordValPtr BuildSVCB_Val(const struct SVCB_DATA&);
 
+    // Returns the owner name of the RR currently being parsed. The StringVal
+    // is only built on first use, so RRs without event handlers don't pay
+    // for it.
+    const StringValPtr& QueryName();
+    void SetQueryName(const u_char* name, int len);
+
     int id;
     int opcode;   ///< query type, see DNS_Opcode
     int rcode;    ///< return code, see DNS_Code
@@ -315,7 +323,9 @@ public:
     int arcount;  ///< number of additional RRs
     int is_query; ///< whether it came from the session initiator
 
-    StringValPtr query_name;
+    const u_char* query_name_data = nullptr; ///< valid only while the current RR is parsed
+    int query_name_len = 0;
+    StringValPtr query_name; ///< lazily built from query_name_data
     RR_Type atype;
     int aclass; ///< normally = 1, inet
     uint32_t ttl;
@@ -388,9 +398,28 @@ protected:
     void SendReplyOrRejectEvent(detail::DNS_MsgInfo* msg, EventHandlerPtr event, const u_char*& data, int& len,
                                 String* question_name, String* original_name);
 
+    // A name that was already decompressed while parsing the current
+    // message, keyed by the message offset a compression pointer targets.
+    struct CachedName {
+        uint16_t offset;       ///< message offset of the name
+        uint16_t consumed;     ///< wire bytes the name occupies at that offset
+        uint32_t arena_offset; ///< start of the decompressed name in name_arena
+        uint16_t len;          ///< length of the decompressed name
+    };
+
+    const CachedName* LookupName(uint16_t offset, int max_len, int name_len) const;
+    void CacheName(uint16_t offset, int consumed, const u_char* name, int len);
+
     analyzer::Analyzer* analyzer;
     bool first_message;
     bool is_netbios;
+
+    // Per-message state for resolving compression pointers only once. Both
+    // containers are cleared (but keep their capacity) for every message,
+    // and the anomaly count is reset.
+    std::vector<CachedName> name_cache;
+    std::vector<u_char> name_arena;
+    uint32_t name_anomalies = 0; ///< bumped whenever name extraction stops early
 };
 
 enum TCP_DNS_state {
@@ -2,11 +2,37 @@
 
 #include "zeek/plugin/Plugin.h"
 
+#include "zeek/Conn.h"
+#include "zeek/ID.h"
+#include "zeek/Val.h"
 #include "zeek/analyzer/Component.h"
+#include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/file/File.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek::plugin::detail::Zeek_File {
 
+namespace {
+
+// Mirrors FTP::get_file_handle() in base/protocols/ftp/files.zeek.
+std::optional<std::string> get_file_handle(const zeek::Tag& tag, zeek::Connection* c, bool is_orig) {
+    static auto ftp_data_expected = zeek::id::find_val<zeek::TableVal>("FTP::ftp_data_expected");
+
+    const auto& conn = c->GetVal();
+    auto id = conn->GetField<zeek::RecordVal>("id");
+
+    auto index = zeek::make_intrusive<zeek::ListVal>(zeek::TYPE_ANY);
+    index->Append(id->GetField("resp_h"));
+    index->Append(id->GetField("resp_p"));
+
+    if ( ! ftp_data_expected->Find(index) )
+        return "";
+
+    return zeek::file_analysis::cat_vals({tag.AsVal(), conn->GetField("start_time"), id, zeek::val_mgr->Bool(is_orig)});
+}
+
+} // namespace
+
 class Plugin : public zeek::plugin::Plugin {
 public:
     zeek::plugin::Configuration Configure() override {
@@ -17,6 +43,12 @@ public:
         config.description = "Generic file analyzer";
         return config;
     }
+
+    void InitPostScript() override {
+        zeek::plugin::Plugin::InitPostScript();
+        zeek::file_mgr->RegisterFileHandleFunc(zeek::analyzer_mgr->GetComponentTag("FTP_DATA"), "FTP::get_file_handle",
+                                               get_file_handle);
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_File
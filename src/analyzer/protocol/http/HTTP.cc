@@ -227,16 +227,14 @@ bool HTTP_Entity::Undelivered(int64_t len) {
         return false;
 
     if ( is_partial_content ) {
-        precomputed_file_id =
-            file_mgr->Gap(body_length, len, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
-                          http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), precomputed_file_id);
+        file_mgr->Gap(body_length, len, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
+                      http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), file_handle);
 
         offset += len;
     }
     else
-        precomputed_file_id =
-            file_mgr->Gap(body_length, len, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
-                          http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), precomputed_file_id);
+        file_mgr->Gap(body_length, len, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
+                      http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), file_handle);
 
     if ( chunked_transfer_state != NON_CHUNKED_TRANSFER ) {
         if ( chunked_transfer_state == EXPECT_CHUNK_DATA && expect_data_length >= len ) {
@@ -283,27 +281,22 @@ void HTTP_Entity::SubmitData(int len, const char* buf) {
 
     if ( is_partial_content ) {
         if ( send_size && instance_length > 0 )
-            precomputed_file_id =
-                file_mgr->SetSize(instance_length, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
-                                  http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), precomputed_file_id);
+            file_mgr->SetSize(instance_length, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
+                              http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), file_handle);
 
-        precomputed_file_id =
-            file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len, offset,
-                             http_message->MyHTTP_Analyzer()->GetAnalyzerTag(), http_message->MyHTTP_Analyzer()->Conn(),
-                             http_message->IsOrig(), precomputed_file_id);
+        file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len, offset,
+                         http_message->MyHTTP_Analyzer()->GetAnalyzerTag(), http_message->MyHTTP_Analyzer()->Conn(),
+                         http_message->IsOrig(), file_handle);
 
         offset += len;
     }
     else {
         if ( send_size && content_length > 0 )
-            precomputed_file_id =
-                file_mgr->SetSize(content_length, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
-                                  http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), precomputed_file_id);
-
-        precomputed_file_id =
-            file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len,
-                             http_message->MyHTTP_Analyzer()->GetAnalyzerTag(), http_message->MyHTTP_Analyzer()->Conn(),
-                             http_message->IsOrig(), precomputed_file_id);
+            file_mgr->SetSize(content_length, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
+                              http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), file_handle);
+
+        file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len, http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
+                         http_message->MyHTTP_Analyzer()->Conn(), http_message->IsOrig(), file_handle);
     }
 
     send_size = false;
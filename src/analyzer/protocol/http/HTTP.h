@@ -10,6 +10,7 @@
 #include "zeek/analyzer/protocol/tcp/TCP.h"
 #include "zeek/analyzer/protocol/zip/ZIP.h"
 #include "zeek/binpac_zeek.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek::analyzer::http {
 
@@ -43,7 +44,7 @@ public:
     int64_t BodyLength() const { return body_length; }
     int64_t HeaderLength() const { return header_length; }
     void SkipBody() { deliver_body = 0; }
-    const string& FileID() const { return precomputed_file_id; }
+    const string& FileID() const { return file_handle.ID(); }
 
 protected:
     class UncompressedOutput;
@@ -64,7 +65,7 @@ protected:
     uint64_t offset;
     int64_t instance_length; // total length indicated by content-range
     bool send_size;          // whether to send size indication to FAF
-    std::string precomputed_file_id;
+    file_analysis::FileHandle file_handle;
 
     analyzer::mime::MIME_Entity* NewChildEntity() override { return new HTTP_Entity(http_message, this, 1); }
 
@@ -2,11 +2,51 @@
 
 #include "zeek/plugin/Plugin.h"
 
+#include "zeek/Conn.h"
+#include "zeek/Desc.h"
+#include "zeek/Val.h"
 #include "zeek/analyzer/Component.h"
+#include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/http/HTTP.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek::plugin::detail::Zeek_HTTP {
 
+namespace {
+
+// Mirrors HTTP::get_file_handle() in base/protocols/http/files.zeek.
+std::optional<std::string> get_file_handle(const zeek::Tag& tag, zeek::Connection* c, bool is_orig) {
+    const auto& conn = c->GetVal();
+
+    if ( ! conn->HasField("http") )
+        return "";
+
+    auto http = conn->GetField<zeek::RecordVal>("http");
+
+    // Handles for range requests use build_url(); leave those to the
+    // script version, as well as the runtime error it reports for a
+    // missing trans_depth.
+    if ( (http->GetFieldOrDefault("range_request")->AsBool() && ! is_orig) || ! http->HasField("trans_depth") )
+        return std::nullopt;
+
+    auto id = conn->GetField<zeek::RecordVal>("id");
+
+    // Same as id_string() from base/utils/conn-ids.zeek.
+    zeek::ODesc id_string;
+    id_string.SetStyle(zeek::RAW_STYLE);
+    id->GetField("orig_h")->Describe(&id_string);
+    id_string.Add(zeek::util::fmt(":%u > ", id->GetField<zeek::PortVal>("orig_p")->Port()));
+    id->GetField("resp_h")->Describe(&id_string);
+    id_string.Add(zeek::util::fmt(":%u", id->GetField<zeek::PortVal>("resp_p")->Port()));
+
+    return zeek::file_analysis::cat_vals(
+        {tag.AsVal(), conn->GetField("start_time"), zeek::val_mgr->Bool(is_orig), http->GetField("trans_depth"),
+         http->GetFieldOrDefault(is_orig ? "orig_mime_depth" : "resp_mime_depth"),
+         zeek::make_intrusive<zeek::StringVal>(id_string.Description())});
+}
+
+} // namespace
+
 class Plugin : public zeek::plugin::Plugin {
 public:
     zeek::plugin::Configuration Configure() override {
@@ -17,6 +57,12 @@ public:
         config.description = "HTTP analyzer";
         return config;
     }
+
+    void InitPostScript() override {
+        zeek::plugin::Plugin::InitPostScript();
+        zeek::file_mgr->RegisterFileHandleFunc(zeek::analyzer_mgr->GetComponentTag("HTTP"), "HTTP::get_file_handle",
+                                               get_file_handle);
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_HTTP
@@ -2,11 +2,26 @@
 
 #include "zeek/plugin/Plugin.h"
 
+#include "zeek/Conn.h"
+#include "zeek/Val.h"
 #include "zeek/analyzer/Component.h"
+#include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/irc/IRC.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek::plugin::detail::Zeek_IRC {
 
+namespace {
+
+// Mirrors IRC::get_file_handle() in base/protocols/irc/files.zeek.
+std::optional<std::string> get_file_handle(const zeek::Tag& tag, zeek::Connection* c, bool is_orig) {
+    const auto& conn = c->GetVal();
+    return zeek::file_analysis::cat_vals(
+        {tag.AsVal(), conn->GetField("start_time"), conn->GetField("id"), zeek::val_mgr->Bool(is_orig)});
+}
+
+} // namespace
+
 class Plugin : public zeek::plugin::Plugin {
 public:
     zeek::plugin::Configuration Configure() override {
@@ -18,6 +33,12 @@ public:
         config.description = "IRC analyzer";
         return config;
     }
+
+    void InitPostScript() override {
+        zeek::plugin::Plugin::InitPostScript();
+        zeek::file_mgr->RegisterFileHandleFunc(zeek::analyzer_mgr->GetComponentTag("IRC_DATA"), "IRC::get_file_handle",
+                                               get_file_handle);
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_IRC
@@ -123,8 +123,7 @@ int fputs(data_chunk_t b, FILE* fp) {
 }
 
 void MIME_Mail::Undelivered(int len) {
-    cur_entity_id =
-        file_mgr->Gap(cur_entity_len, len, analyzer->GetAnalyzerTag(), analyzer->Conn(), is_orig, cur_entity_id);
+    file_mgr->Gap(cur_entity_len, len, analyzer->GetAnalyzerTag(), analyzer->Conn(), is_orig, cur_entity_file);
 }
 
 bool istrequal(data_chunk_t s, const char* t) {
@@ -913,6 +912,14 @@ void MIME_Entity::DecodeBinary(int len, const char* data, bool trailing_CRLF) {
     }
 }
 
+// Characters that quoted-printable encoding passes through unchanged:
+// printable ASCII except '=', plus HT and SP.
+static inline bool IsLiteralQPChar(char c) {
+    return (c >= 33 && c <= 60) ||
+           // except controls, whitespace and '='
+           (c >= 62 && c <= 126) || c == HT || c == SP;
+}
+
 void MIME_Entity::DecodeQuotedPrintable(int len, const char* data) {
     // Ignore trailing HT and SP.
     int i;
@@ -950,13 +957,16 @@ void MIME_Entity::DecodeQuotedPrintable(int len, const char* data) {
             }
         }
 
-        else if ( (data[i] >= 33 && data[i] <= 60) ||
-                  // except controls, whitespace and '='
-                  (data[i] >= 62 && data[i] <= 126) )
-            DataOctet(data[i]);
+        else if ( IsLiteralQPChar(data[i]) ) {
+            // Pass on the whole run of literal characters at once rather
+            // than octet by octet.
+            int j = i + 1;
+            while ( j <= end_of_line && IsLiteralQPChar(data[j]) )
+                ++j;
 
-        else if ( data[i] == HT || data[i] == SP )
-            DataOctet(data[i]);
+            DataOctets(j - i, data + i);
+            i = j - 1;
+        }
 
         else {
             IllegalEncoding(util::fmt("control characters in quoted-printable encoding: %d", (int)(data[i])));
@@ -971,14 +981,35 @@ void MIME_Entity::DecodeQuotedPrintable(int len, const char* data) {
 }
 
 void MIME_Entity::DecodeBase64(int len, const char* data) {
-    int rlen;
-    char rbuf[128];
-
     while ( len > 0 ) {
-        rlen = 128;
-        char* prbuf = rbuf;
-        int decoded = base64_decoder->Decode(len, data, &rlen, &prbuf);
-        DataOctets(rlen, rbuf);
+        bool have_buffer = data_buf_offset >= 0 || GetDataBuffer();
+        int rlen = have_buffer ? data_buf_length - data_buf_offset : 0;
+        int decoded;
+
+        if ( rlen < 3 ) {
+            // Not enough room left for a full decoded group, or no buffer
+            // at all. Decode on the side, so that encoding errors still
+            // get reported, and let DataOctets() split the result across
+            // data buffers or drop it.
+            char rbuf[128];
+            char* prbuf = rbuf;
+            rlen = sizeof(rbuf);
+            decoded = base64_decoder->Decode(len, data, &rlen, &prbuf);
+            DataOctets(rlen, rbuf);
+        }
+        else {
+            // Decode straight into the data buffer, saving the copy
+            // through an intermediate buffer.
+            char* prbuf = data_buf_data + data_buf_offset;
+            decoded = base64_decoder->Decode(len, data, &rlen, &prbuf);
+            data_buf_offset += rlen;
+
+            if ( data_buf_offset == data_buf_length ) {
+                SubmitData(data_buf_length, data_buf_data);
+                data_buf_offset = -1;
+            }
+        }
+
         len -= decoded;
         data += decoded;
     }
@@ -1206,7 +1237,7 @@ MIME_Mail::~MIME_Mail() {
 
 void MIME_Mail::BeginEntity(MIME_Entity* /* entity */) {
     cur_entity_len = 0;
-    cur_entity_id.clear();
+    cur_entity_file.Reset();
 
     if ( mime_begin_entity )
         analyzer->EnqueueConnEvent(mime_begin_entity, analyzer->ConnVal());
@@ -1231,12 +1262,12 @@ void MIME_Mail::EndEntity(MIME_Entity* /* entity */) {
     if ( mime_end_entity )
         analyzer->EnqueueConnEvent(mime_end_entity, analyzer->ConnVal());
 
-    if ( ! cur_entity_id.empty() )
-        file_mgr->EndOfFile(cur_entity_id);
+    if ( ! cur_entity_file.ID().empty() )
+        file_mgr->EndOfFile(cur_entity_file.ID());
     else
         file_mgr->EndOfFile(analyzer->GetAnalyzerTag(), analyzer->Conn());
 
-    cur_entity_id.clear();
+    cur_entity_file.Reset();
 }
 
 void MIME_Mail::SubmitHeader(MIME_Header* h) {
@@ -1277,8 +1308,8 @@ void MIME_Mail::SubmitData(int len, const char* buf) {
                                    make_intrusive<StringVal>(data_len, data));
     }
 
-    cur_entity_id = file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len, analyzer->GetAnalyzerTag(),
-                                     analyzer->Conn(), is_orig, cur_entity_id);
+    file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len, analyzer->GetAnalyzerTag(), analyzer->Conn(), is_orig,
+                     cur_entity_file);
 
     cur_entity_len += len;
     buffer_start = (buf + len) - (char*)data_buffer->Bytes();
@@ -9,6 +9,7 @@
 #include "zeek/ZeekString.h"
 #include "zeek/analyzer/Analyzer.h"
 #include "zeek/digest.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek {
 
@@ -263,7 +264,7 @@ protected:
     String* data_buffer;
 
     uint64_t cur_entity_len;
-    std::string cur_entity_id;
+    file_analysis::FileHandle cur_entity_file;
 };
 
 extern bool is_null_data_chunk(data_chunk_t b);
@@ -0,0 +1,503 @@
+#include "zeek/analyzer/protocol/pia/Classifier.h"
+
+#include <strings.h>
+#include <cctype>
+#include <cstring>
+
+#include "zeek/3rdparty/doctest.h"
+
+namespace zeek::analyzer::pia::detail {
+
+namespace {
+
+bool has_prefix(const u_char* data, int len, const char* prefix) {
+    int n = strlen(prefix);
+    return len >= n && memcmp(data, prefix, n) == 0;
+}
+
+bool has_prefix_nocase(const u_char* data, int len, const char* prefix) {
+    int n = strlen(prefix);
+    return len >= n && strncasecmp(reinterpret_cast<const char*>(data), prefix, n) == 0;
+}
+
+int skip_space(const u_char* data, int len) {
+    int i = 0;
+    while ( i < len && isspace(data[i]) )
+        ++i;
+
+    return i;
+}
+
+// dpd_tls_client
+bool is_tls_client_hello(const u_char* d, int len) {
+    return len >= 11 && d[0] == 0x16 && d[1] == 0x03 && d[2] <= 0x03 && d[5] == 0x01 && d[9] == 0x03 && d[10] <= 0x03;
+}
+
+// dpd_tls_server, without the optional leading alert.
+bool is_tls_server_hello(const u_char* d, int len) {
+    return len >= 11 && d[0] == 0x16 && d[1] == 0x03 && d[2] <= 0x03 && d[5] == 0x02 &&
+           ((d[9] == 0x03 && d[10] <= 0x04) || (d[9] == 0x7f && d[10] <= 0x50));
+}
+
+// dpd_http_client, requiring a space after the method.
+bool is_http_request(const u_char* d, int len) {
+    static const char* methods[] = {"GET ",     "POST ",    "HEAD ",  "PUT ",      "DELETE ",
+                                    "OPTIONS ", "CONNECT ", "TRACE ", "PROPFIND ", "PATCH "};
+
+    int i = skip_space(d, len);
+
+    for ( const auto* m : methods )
+        if ( has_prefix(d + i, len - i, m) )
+            return true;
+
+    return false;
+}
+
+// dpd_smb
+bool is_smb(const u_char* d, int len) {
+    return len >= 8 && (d[4] == 0xfe || d[4] == 0xff) && memcmp(d + 5, "SMB", 3) == 0;
+}
+
+// dpd_dce_rpc, anchored at the beginning.
+bool is_dce_rpc(const u_char* d, int len) { return len >= 3 && d[0] == 0x05 && d[1] <= 0x01 && d[2] <= 0x13; }
+
+// dpd_ssh_client / dpd_ssh_server
+bool is_ssh_banner(const u_char* d, int len) {
+    return has_prefix_nocase(d, len, "ssh-") && len >= 6 && (d[4] == '1' || d[4] == '2') && d[5] == '.';
+}
+
+// dpd_smtp_server
+bool is_smtp_greeting(const u_char* d, int len) {
+    int i = skip_space(d, len);
+    return has_prefix(d + i, len - i, "220") && len - i >= 4 && (isspace(d[i + 3]) || d[i + 3] == '-');
+}
+
+// dpd_smtp_client
+bool is_smtp_hello(const u_char* d, int len) {
+    int i = skip_space(d, len);
+    return has_prefix_nocase(d + i, len - i, "helo") || has_prefix_nocase(d + i, len - i, "ehlo");
+}
+
+// dpd_pop3_client
+bool is_pop3_command(const u_char* d, int len) {
+    int i = skip_space(d, len);
+    d += i;
+    len -= i;
+
+    return ((has_prefix_nocase(d, len, "user") || has_prefix_nocase(d, len, "apop")) && len >= 5 && isspace(d[4])) ||
+           has_prefix_nocase(d, len, "capa") || has_prefix_nocase(d, len, "auth");
+}
+
+// dpd_rdp_client: TPKT + X.224 connection request carrying the cookie.
+bool is_rdp_request(const u_char* d, int len) {
+    return len >= 11 && d[0] == 0x03 && d[1] == 0x00 && d[5] == 0xe0 &&
+           has_prefix(d + 11, len - 11, "Cookie: mstshash=");
+}
+
+// dpd_rdp_server: X.224 connection confirm.
+bool is_rdp_confirm(const u_char* d, int len) { return len >= 6 && d[5] == 0xd0; }
+
+// dpd_dtls_client
+bool is_dtls_client_hello(const u_char* d, int len) {
+    static const u_char zeros[8] = {0};
+    return len >= 27 && d[0] == 0x16 && d[1] == 0xfe && (d[2] == 0xff || d[2] == 0xfd) &&
+           memcmp(d + 3, zeros, 8) == 0 && d[13] == 0x01 && d[25] == 0xfe && (d[26] == 0xff || d[26] == 0xfd);
+}
+
+// dpd_sip_udp_resp
+bool is_sip_response(const u_char* d, int len) {
+    int i = (len > 0 && d[0] == ' ') ? 1 : 0;
+    d += i;
+    len -= i;
+
+    if ( ! (has_prefix(d, len, "SIP/") && len >= 9 && isdigit(d[4]) && d[5] == '.' && isdigit(d[6])) )
+        return false;
+
+    if ( d[7] == '\r' && d[8] == '\n' )
+        return true;
+
+    return len >= 12 && d[7] == ' ' && isdigit(d[8]) && isdigit(d[9]) && isdigit(d[10]) && d[11] == ' ';
+}
+
+// Matches a " *<cmd> +.+" line as used by the IRC client signatures,
+// returning the offset following the line's end, or -1.
+int irc_command_line(const u_char* d, int len, const char* cmd) {
+    int i = 0;
+    while ( i < len && d[i] == ' ' )
+        ++i;
+
+    if ( ! has_prefix_nocase(d + i, len - i, cmd) )
+        return -1;
+
+    i += strlen(cmd);
+    int arg = i;
+
+    if ( i >= len || d[i] != ' ' )
+        return -1;
+
+    while ( i < len && d[i] != '\r' && d[i] != '\n' )
+        ++i;
+
+    // A space plus at least one more character, then the line end.
+    if ( i == len || i - arg < 2 )
+        return -1;
+
+    while ( i < len && (d[i] == '\r' || d[i] == '\n') )
+        ++i;
+
+    return i;
+}
+
+// irc_client1 / irc_client2, starting at the first line.
+bool is_irc_client(const u_char* d, int len) {
+    if ( int n = irc_command_line(d, len, "user"); n > 0 && irc_command_line(d + n, len - n, "nick") > 0 )
+        return true;
+
+    if ( int n = irc_command_line(d, len, "nick"); n > 0 && irc_command_line(d + n, len - n, "user") > 0 )
+        return true;
+
+    return false;
+}
+
+// irc_server_reply, on the first line.
+bool is_irc_reply(const u_char* d, int len) {
+    int i = 0;
+
+    if ( len > 0 && d[0] == ':' ) {
+        i = 1;
+        while ( i < len && d[i] != ' ' && d[i] != '\r' && d[i] != '\n' )
+            ++i;
+
+        if ( i == 1 || i == len || d[i] != ' ' )
+            return false;
+
+        ++i;
+    }
+
+    return len - i >= 4 && isdigit(d[i]) && isdigit(d[i + 1]) && isdigit(d[i + 2]) && d[i + 3] == ' ';
+}
+
+// dpd_ldap_client_tcp / dpd_ldap_client_udp
+bool is_ldap_request(const u_char* d, int len) {
+    return len >= 6 && d[0] == 0x30 && d[2] == 0x02 && d[3] == 0x01 && d[5] == 0x60;
+}
+
+// dpd_xmpp
+bool is_xmpp(const u_char* d, int len) {
+    int i = 0;
+
+    if ( has_prefix(d, len, "<?xml") ) {
+        i = 5;
+        while ( i < len && d[i] != '?' && d[i] != '>' )
+            ++i;
+
+        if ( ! has_prefix(d + i, len - i, "?>") )
+            return false;
+
+        i += 2;
+    }
+
+    while ( i < len && (d[i] == '\n' || d[i] == '\r' || d[i] == ' ') )
+        ++i;
+
+    if ( ! has_prefix(d + i, len - i, "<stream:stream ") )
+        return false;
+
+    for ( i += 15; i < len && d[i] != '>'; ++i )
+        if ( has_prefix(d + i, len - i, "xmlns='jabber:") )
+            return true;
+
+    return false;
+}
+
+// dpd_socks4_client
+bool is_socks4_request(const u_char* d, int len) {
+    if ( len < 3 || d[0] != 0x04 || (d[1] != 0x01 && d[1] != 0x02) )
+        return false;
+
+    for ( int i = 2; i < len && i <= 34; ++i )
+        if ( d[i] == 0x00 )
+            return true;
+
+    return false;
+}
+
+// dpd_socks4_server
+bool is_socks4_reply(const u_char* d, int len) { return len >= 2 && d[0] == 0x00 && d[1] >= 0x5a && d[1] <= 0x5d; }
+
+// dpd_socks5_client, further requiring the payload to be exactly the method
+// list, so that it doesn't catch DCE-RPC PDUs.
+bool is_socks5_greeting(const u_char* d, int len) {
+    return len >= 3 && d[0] == 0x05 && len == 2 + d[1] && d[2] <= 0x09 && d[2] != 0x04;
+}
+
+// dpd_socks5_server
+bool is_socks5_choice(const u_char* d, int len) {
+    return len >= 2 && d[0] == 0x05 && ((d[1] <= 0x09 && d[1] != 0x04) || d[1] == 0xff);
+}
+
+// dpd_postgresql_client_sslrequest
+bool is_postgresql_ssl_request(const u_char* d, int len) {
+    static const u_char request[] = {0x00, 0x00, 0x00, 0x08, 0x04, 0xd2, 0x16, 0x2f};
+    return len >= 8 && memcmp(d, request, sizeof(request)) == 0;
+}
+
+// dpd_mqtt
+bool is_mqtt(const u_char* d, int len) {
+    for ( int i = 4; i <= 7 && i + 2 <= len; ++i )
+        if ( d[i] == 'M' && d[i + 1] == 'Q' )
+            return true;
+
+    return false;
+}
+
+// The dpd_krb_* patterns: "(<types>).{1,4}\x30.{1,4}<tail>".
+bool is_krb_message(const u_char* d, int len, const u_char* types, int num_types, const u_char* tail) {
+    constexpr int tail_len = 9;
+
+    if ( len < 1 || ! memchr(types, d[0], num_types) )
+        return false;
+
+    for ( int i = 2; i <= 5 && i < len; ++i ) {
+        if ( d[i] != 0x30 )
+            continue;
+
+        for ( int j = i + 2; j <= i + 5 && j + tail_len <= len; ++j )
+            if ( memcmp(d + j, tail, tail_len) == 0 )
+                return true;
+    }
+
+    return false;
+}
+
+bool is_krb(const u_char* d, int len) {
+    static const u_char request_types[] = {0x6a, 0x6c};
+    static const u_char request_tail[] = {0xa1, 0x03, 0x02, 0x01, 0x05, 0xa2, 0x03, 0x02, 0x01};
+    static const u_char reply_types[] = {0x6b, 0x6d, 0x7e};
+    static const u_char reply_tail[] = {0xa0, 0x03, 0x02, 0x01, 0x05, 0xa1, 0x03, 0x02, 0x01};
+
+    return is_krb_message(d, len, request_types, sizeof(request_types), request_tail) ||
+           is_krb_message(d, len, reply_types, sizeof(reply_types), reply_tail);
+}
+
+// dhcp_cookie
+bool is_dhcp(const u_char* d, int len) {
+    static const u_char cookie[] = {0x63, 0x82, 0x53, 0x63};
+    return len >= 240 && memcmp(d + 236, cookie, sizeof(cookie)) == 0;
+}
+
+// dpd_dnp3_server / dpd_dnp3_server_udp
+bool is_dnp3(const u_char* d, int len) { return len >= 2 && d[0] == 0x05 && d[1] == 0x64; }
+
+Classification classify_tcp(const u_char* d, int len, bool is_orig) {
+    if ( is_orig ) {
+        if ( is_tls_client_hello(d, len) )
+            return {"SSL", false};
+
+        if ( is_http_request(d, len) )
+            return {"HTTP", false};
+
+        if ( is_ssh_banner(d, len) )
+            return {"SSH", true};
+
+        if ( is_smtp_hello(d, len) )
+            return {"SMTP", true};
+
+        if ( is_pop3_command(d, len) )
+            return {"POP3", true};
+
+        if ( is_rdp_request(d, len) )
+            return {"RDP", true};
+
+        if ( has_prefix(d, len, "RFB") )
+            return {"RFB", true};
+
+        if ( is_irc_client(d, len) )
+            return {"IRC", true};
+
+        if ( is_ldap_request(d, len) )
+            return {"LDAP_TCP", true};
+
+        if ( is_socks4_request(d, len) || is_socks5_greeting(d, len) )
+            return {"SOCKS", true};
+
+        if ( is_postgresql_ssl_request(d, len) )
+            return {"POSTGRESQL", true};
+    }
+    else {
+        if ( is_tls_server_hello(d, len) )
+            return {"SSL", false};
+
+        if ( has_prefix(d, len, "HTTP/") && len >= 6 && isdigit(d[5]) )
+            return {"HTTP", false};
+
+        if ( is_ssh_banner(d, len) )
+            return {"SSH", true};
+
+        if ( is_smtp_greeting(d, len) )
+            return {"SMTP", true};
+
+        if ( has_prefix(d, len, "+OK") )
+            return {"POP3", true};
+
+        if ( is_rdp_confirm(d, len) )
+            return {"RDP", true};
+
+        if ( has_prefix(d, len, "RFB") )
+            return {"RFB", true};
+
+        if ( is_irc_reply(d, len) )
+            return {"IRC", true};
+
+        if ( is_dnp3(d, len) )
+            return {"DNP3_TCP", false};
+    }
+
+    if ( is_smb(d, len) )
+        return {"SMB", false};
+
+    if ( is_dce_rpc(d, len) )
+        return {"DCE_RPC", false};
+
+    if ( is_xmpp(d, len) )
+        return {"XMPP", false};
+
+    if ( is_mqtt(d, len) )
+        return {"MQTT", false};
+
+    if ( len > 4 && is_krb(d + 4, len - 4) )
+        return {"KRB_TCP", false};
+
+    // The server sides of these signatures are weak enough to match most
+    // anything, so they only come into play when nothing else matched and
+    // need the client side to agree.
+    if ( ! is_orig ) {
+        if ( is_socks4_reply(d, len) || is_socks5_choice(d, len) )
+            return {"SOCKS", true};
+
+        if ( d[0] == 0x30 )
+            return {"LDAP_TCP", true};
+
+        if ( d[0] == 'S' || d[0] == 'N' )
+            return {"POSTGRESQL", true};
+    }
+
+    return {};
+}
+
+Classification classify_udp(const u_char* d, int len, bool is_orig) {
+    if ( is_dtls_client_hello(d, len) )
+        return {"DTLS", false};
+
+    if ( is_sip_response(d, len) )
+        return {"SIP", false};
+
+    if ( is_dhcp(d, len) )
+        return {"DHCP", false};
+
+    if ( is_dnp3(d, len) )
+        return {"DNP3_UDP", false};
+
+    if ( is_krb(d, len) )
+        return {"KRB", false};
+
+    if ( is_orig && is_ldap_request(d, len) )
+        return {"LDAP_UDP", true};
+
+    if ( ! is_orig && len > 0 && d[0] == 0x30 )
+        return {"LDAP_UDP", true};
+
+    return {};
+}
+
+} // namespace
+
+Classification classify(const u_char* data, int len, bool is_orig, TransportProto proto) {
+    if ( ! data || len <= 0 )
+        return {};
+
+    switch ( proto ) {
+        case TRANSPORT_TCP: return classify_tcp(data, len, is_orig);
+        case TRANSPORT_UDP: return classify_udp(data, len, is_orig);
+        default: return {};
+    }
+}
+
+TEST_SUITE_BEGIN("PIA classifier");
+
+TEST_CASE("tcp") {
+    auto c = [](const char* s, bool is_orig) {
+        return classify(reinterpret_cast<const u_char*>(s), strlen(s), is_orig, TRANSPORT_TCP);
+    };
+
+    CHECK(strcmp(c("GET /index.html HTTP/1.1\r\n", true).analyzer, "HTTP") == 0);
+    CHECK(strcmp(c("HTTP/1.1 200 OK\r\n", false).analyzer, "HTTP") == 0);
+    CHECK(c("HTTP/1.1 200 OK\r\n", false).needs_reverse == false);
+
+    CHECK(strcmp(c("SSH-2.0-OpenSSH_9.6\r\n", true).analyzer, "SSH") == 0);
+    CHECK(c("SSH-2.0-OpenSSH_9.6\r\n", true).needs_reverse);
+    CHECK(c("SSH-3.0-foo\r\n", true).analyzer == nullptr);
+
+    CHECK(strcmp(c("220 mail.example.com ESMTP\r\n", false).analyzer, "SMTP") == 0);
+    CHECK(strcmp(c("EHLO client.example.com\r\n", true).analyzer, "SMTP") == 0);
+
+    CHECK(strcmp(c("NICK joe\r\nUSER joe 0 * :Joe\r\n", true).analyzer, "IRC") == 0);
+    CHECK(strcmp(c(":irc.example.com 001 joe :Welcome\r\n", false).analyzer, "IRC") == 0);
+    CHECK(c("NICK joe\r\n", true).analyzer == nullptr);
+
+    CHECK(strcmp(c("<?xml version='1.0'?><stream:stream to='example.com' xmlns='jabber:client'>", true).analyzer,
+                 "XMPP") == 0);
+
+    CHECK(c("GETTING STARTED\r\n", true).analyzer == nullptr);
+    CHECK(c("hello world", true).analyzer == nullptr);
+}
+
+TEST_CASE("binary") {
+    const u_char client_hello[] = {0x16, 0x03, 0x01, 0x02, 0x00, 0x01, 0x00, 0x01, 0xfc, 0x03, 0x03, 0x00};
+    auto c = classify(client_hello, sizeof(client_hello), true, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "SSL") == 0);
+
+    const u_char smb2[] = {0x00, 0x00, 0x00, 0x40, 0xfe, 'S', 'M', 'B', 0x40, 0x00};
+    c = classify(smb2, sizeof(smb2), true, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "SMB") == 0);
+
+    c = classify(client_hello, sizeof(client_hello), true, TRANSPORT_UDP);
+    CHECK(c.analyzer == nullptr);
+
+    // A SOCKS5 greeting is also a valid start of a DCE-RPC PDU.
+    const u_char socks5[] = {0x05, 0x01, 0x00};
+    c = classify(socks5, sizeof(socks5), true, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "SOCKS") == 0);
+    CHECK(c.needs_reverse);
+
+    const u_char dce_rpc[] = {0x05, 0x00, 0x0b, 0x03, 0x10, 0x00, 0x00, 0x00};
+    c = classify(dce_rpc, sizeof(dce_rpc), true, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "DCE_RPC") == 0);
+
+    const u_char ldap_bind[] = {0x30, 0x0c, 0x02, 0x01, 0x01, 0x60, 0x07, 0x02, 0x01, 0x03};
+    c = classify(ldap_bind, sizeof(ldap_bind), true, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "LDAP_TCP") == 0);
+
+    const u_char pg_ssl[] = {0x00, 0x00, 0x00, 0x08, 0x04, 0xd2, 0x16, 0x2f};
+    c = classify(pg_ssl, sizeof(pg_ssl), true, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "POSTGRESQL") == 0);
+    c = classify(reinterpret_cast<const u_char*>("S"), 1, false, TRANSPORT_TCP);
+    CHECK(strcmp(c.analyzer, "POSTGRESQL") == 0);
+
+    const u_char krb_as_req[] = {0x6a, 0x81, 0xa0, 0x30, 0x81, 0x9d, 0xa1, 0x03, 0x02,
+                                 0x01, 0x05, 0xa2, 0x03, 0x02, 0x01, 0x0a};
+    c = classify(krb_as_req, sizeof(krb_as_req), true, TRANSPORT_UDP);
+    CHECK(strcmp(c.analyzer, "KRB") == 0);
+
+    u_char dhcp[300] = {0};
+    dhcp[236] = 0x63;
+    dhcp[237] = 0x82;
+    dhcp[238] = 0x53;
+    dhcp[239] = 0x63;
+    c = classify(dhcp, sizeof(dhcp), true, TRANSPORT_UDP);
+    CHECK(strcmp(c.analyzer, "DHCP") == 0);
+}
+
+TEST_SUITE_END();
+
+} // namespace zeek::analyzer::pia::detail
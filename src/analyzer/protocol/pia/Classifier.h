@@ -0,0 +1,31 @@
+// A cheap first-stage protocol classifier for the PIA.
+
+#pragma once
+
+#include <sys/types.h> // for u_char
+
+#include "zeek/net_util.h"
+
+namespace zeek::analyzer::pia::detail {
+
+// Result of classifying the first payload of one direction of a connection.
+struct Classification {
+    // Name of the analyzer the payload belongs to, or null if the
+    // classifier isn't sure.
+    const char* analyzer = nullptr;
+
+    // If true, the other direction must classify as the same analyzer
+    // before the analyzer gets activated. This mirrors DPD signatures
+    // using requires-reverse-signature.
+    bool needs_reverse = false;
+};
+
+// Checks the beginning of a direction's payload against hand-coded byte
+// patterns for common protocols. Each pattern matches a subset of what the
+// corresponding DPD signature in base/protocols/*/dpd.sig matches, so a hit
+// never activates an analyzer the signature engine would not have
+// activated as well; it just does so without going through the matcher.
+// Anything less clear-cut is left to the signatures.
+Classification classify(const u_char* data, int len, bool is_orig, TransportProto proto);
+
+} // namespace zeek::analyzer::pia::detail
@@ -7,8 +7,11 @@
 #include "zeek/Reporter.h"
 #include "zeek/RuleMatcher.h"
 #include "zeek/RunState.h"
+#include "zeek/analyzer/Manager.h"
+#include "zeek/analyzer/protocol/pia/Classifier.h"
 #include "zeek/analyzer/protocol/tcp/TCP_Flags.h"
 #include "zeek/analyzer/protocol/tcp/TCP_Reassembler.h"
+#include "zeek/telemetry/Manager.h"
 
 namespace zeek::analyzer::pia {
 
@@ -88,6 +91,8 @@ void PIA::PIA_DeliverPacket(int len, const u_char* data, bool is_orig, uint64_t
         AddToBuffer(&pkt_buffer, seq, len, data, is_orig, ip);
         if ( pkt_buffer.size > zeek::detail::dpd_buffer_size || ++pkt_buffer.chunks > zeek::detail::dpd_max_packets )
             new_state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
+
+        Classify(data, len, is_orig, Conn()->ConnTransport());
     }
 
     // FIXME: I'm not sure why it does not work with eol=true...
@@ -122,6 +127,56 @@ void PIA::DoMatch(const u_char* data, int len, bool is_orig, bool bol, bool eol,
     zeek::detail::RuleMatcherState::Match(zeek::detail::Rule::PAYLOAD, data, len, is_orig, bol, eol, clear_state);
 }
 
+void PIA::Classify(const u_char* data, int len, bool is_orig, TransportProto proto) {
+    if ( ! zeek::detail::dpd_fast_classifier || ! data || len <= 0 )
+        return;
+
+    int idx = is_orig ? 1 : 0;
+
+    if ( classified[idx] )
+        return;
+
+    classified[idx] = true;
+
+    static auto hits =
+        telemetry_mgr->ShardedCounterInstance("zeek", "dpd_classifier_hits", {},
+                                              "Number of analyzers activated by the DPD fast classifier");
+    static auto misses = telemetry_mgr->ShardedCounterInstance("zeek", "dpd_classifier_misses", {},
+                                                               "Number of payloads left to the DPD signatures");
+    static auto deferred =
+        telemetry_mgr->ShardedCounterInstance("zeek", "dpd_classifier_deferred", {},
+                                              "Number of payloads matching a pattern without activating an analyzer");
+
+    auto c = detail::classify(data, len, is_orig, proto);
+
+    if ( ! c.analyzer ) {
+        misses->Inc();
+        return;
+    }
+
+    classified_as[idx] = c.analyzer;
+
+    // Same as requires-reverse-signature: wait for the other side.
+    if ( c.needs_reverse && (! classified_as[1 - idx] || strcmp(classified_as[1 - idx], c.analyzer) != 0) ) {
+        deferred->Inc();
+        return;
+    }
+
+    zeek::Tag tag = analyzer_mgr->GetComponentTag(c.analyzer);
+
+    // Only stand in for signatures that are actually loaded, which for
+    // example isn't the case for most protocols in bare mode.
+    if ( ! tag || ! analyzer_mgr->IsEnabled(tag) || ! zeek::detail::rule_matcher ||
+         ! zeek::detail::rule_matcher->HasEnableRule(tag) ) {
+        deferred->Inc();
+        return;
+    }
+
+    DBG_LOG(DBG_ANALYZER, "PIA classifier activating %s", c.analyzer);
+    hits->Inc();
+    ActivateAnalyzer(tag, nullptr);
+}
+
 void PIA_UDP::ActivateAnalyzer(zeek::Tag tag, const zeek::detail::Rule* rule) {
     if ( pkt_buffer.state == MATCHING_ONLY ) {
         DBG_LOG(DBG_ANALYZER, "analyzer found but buffer already exceeded");
@@ -299,6 +354,8 @@ void PIA_TCP::DeliverStream(int len, const u_char* data, bool is_orig) {
         if ( stream_buffer.size > zeek::detail::dpd_buffer_size ||
              ++stream_buffer.chunks > zeek::detail::dpd_max_packets )
             new_state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
+
+        Classify(data, len, is_orig, TRANSPORT_TCP);
     }
 
     DoMatch(data, len, is_orig, false, false, false, nullptr);
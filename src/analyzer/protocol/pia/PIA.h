@@ -103,6 +103,11 @@ protected:
     void DoMatch(const u_char* data, int len, bool is_orig, bool bol, bool eol, bool clear_state,
                  const IP_Hdr* ip = nullptr);
 
+    // Passes the first payload of each direction through the byte-pattern
+    // classifier if dpd_fast_classifier is set, activating the analyzer it
+    // identifies. Signature matching continues regardless.
+    void Classify(const u_char* data, int len, bool is_orig, TransportProto proto);
+
     auto Conn() const { return conn; }
     void SetConn(Connection* c) { conn = c; }
 
@@ -115,6 +120,10 @@ private:
     analyzer::Analyzer* as_analyzer;
     Connection* conn;
     DataBlock current_packet;
+
+    // Per-direction classifier state, indexed by is_orig.
+    bool classified[2] = {false, false};
+    const char* classified_as[2] = {nullptr, nullptr};
 };
 
 // PIA for UDP.
@@ -10,7 +10,9 @@ WARNING: THIS CODE IS NOT SAFE IN MULTI-THREADED ENVIRONMENTS:
 The involved contexts are EVP_CIPHER_CTX and EVP_PKEY_CTX. These are allocated
 lazily and re-used for performance reasons. Previously, every decrypt operation
 allocated, initialized and freed these individually, resulting in a significant
-performance hit. Given Zeek's single threaded nature, this is fine.
+performance hit. Given Zeek's single threaded nature, this is fine. The cipher
+contexts are kept per DCID and direction together with the derived keys, so
+packets of an already seen connection skip key derivation entirely.
 */
 
 /*
@@ -26,6 +28,7 @@ refactors as C++ development is not our main profession.
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // OpenSSL imports
@@ -63,38 +66,90 @@ const size_t AEAD_TAG_LENGTH = 16;
 const size_t MAXIMUM_PACKET_LENGTH = 1500;
 const size_t MAXIMUM_PACKET_NUMBER_LENGTH = 4;
 
-EVP_CIPHER_CTX* get_aes_128_ecb() {
-    static EVP_CIPHER_CTX* ctx = nullptr;
-    if ( ! ctx ) {
-        ctx = EVP_CIPHER_CTX_new();
-        EVP_CipherInit_ex(ctx, EVP_aes_128_ecb(), NULL, NULL, NULL, 1);
+/*
+Keys and initialized cipher contexts derived from the Initial secret of one
+direction of a connection. All Initial packets of a connection use the same
+DCID, so these are derived once and then reused for every packet, instead of
+running HKDF and the AES key schedules again each time.
+*/
+struct InitialKeys {
+    std::vector<uint8_t> iv;
+
+    // AES-128-ECB keyed with the header protection key.
+    EVP_CIPHER_CTX* hp_ctx = nullptr;
+
+    // AES-128-GCM keyed with the packet protection key. Only the nonce
+    // changes between packets.
+    EVP_CIPHER_CTX* aead_ctx = nullptr;
+
+    InitialKeys(const std::vector<uint8_t>& key, std::vector<uint8_t> arg_iv, const std::vector<uint8_t>& hp)
+        : iv(std::move(arg_iv)) {
+        hp_ctx = EVP_CIPHER_CTX_new();
+        EVP_CipherInit_ex(hp_ctx, EVP_aes_128_ecb(), NULL, NULL, NULL, 1);
+        EVP_CIPHER_CTX_set_key_length(hp_ctx, hp.size());
+        // Passing an 1 means ENCRYPT
+        EVP_CipherInit_ex(hp_ctx, NULL, NULL, hp.data(), NULL, 1);
+
+        aead_ctx = EVP_CIPHER_CTX_new();
+        EVP_CipherInit_ex(aead_ctx, EVP_aes_128_gcm(), NULL, NULL, NULL, 0);
+        EVP_CIPHER_CTX_ctrl(aead_ctx, EVP_CTRL_CCM_SET_IVLEN, AEAD_IV_LEN, NULL);
+        EVP_CIPHER_CTX_set_key_length(aead_ctx, key.size());
+        EVP_CipherInit_ex(aead_ctx, NULL, NULL, key.data(), NULL, 0);
     }
 
-    return ctx;
-}
+    ~InitialKeys() {
+        EVP_CIPHER_CTX_free(hp_ctx);
+        EVP_CIPHER_CTX_free(aead_ctx);
+    }
 
-EVP_CIPHER_CTX* get_aes_128_gcm() {
-    static EVP_CIPHER_CTX* ctx = nullptr;
-    if ( ! ctx ) {
-        ctx = EVP_CIPHER_CTX_new();
-        EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), NULL, NULL, NULL, 1);
+    InitialKeys(const InitialKeys&) = delete;
+    InitialKeys& operator=(const InitialKeys&) = delete;
+};
+
+/*
+Cache of InitialKeys indexed by version, direction and DCID. It's bounded
+and simply starts over when full: connections that are still active just
+re-derive their keys on their next packet.
+*/
+class InitialKeysCache {
+public:
+    InitialKeys* Lookup(const std::string& index) {
+        auto it = keys.find(index);
+        return it != keys.end() ? it->second.get() : nullptr;
     }
 
-    return ctx;
-}
+    InitialKeys* Insert(std::string index, std::unique_ptr<InitialKeys> k) {
+        if ( keys.size() >= MAX_ENTRIES )
+            keys.clear();
+
+        auto* result = k.get();
+        keys[std::move(index)] = std::move(k);
+        return result;
+    }
+
+    static std::string Index(uint32_t version, bool from_client, const hilti::rt::Bytes& connection_id) {
+        std::string index;
+        index.reserve(sizeof(version) + 1 + connection_id.size());
+        index.append(reinterpret_cast<const char*>(&version), sizeof(version));
+        index.push_back(from_client ? 'c' : 's');
+        index.append(connection_id.str());
+        return index;
+    }
+
+private:
+    static constexpr size_t MAX_ENTRIES = 4096;
+
+    std::unordered_map<std::string, std::unique_ptr<InitialKeys>> keys;
+};
 
 /*
 Removes the header protection from the INITIAL packet and returns a DecryptionInformation struct
 that is partially filled
 */
-DecryptionInformation remove_header_protection(const std::vector<uint8_t>& client_hp, uint64_t encrypted_offset,
+DecryptionInformation remove_header_protection(EVP_CIPHER_CTX* hp_ctx, uint64_t encrypted_offset,
                                                const hilti::rt::Bytes& all_data) {
     DecryptionInformation decryptInfo;
     int outlen;
-    auto* ctx = get_aes_128_ecb();
-    EVP_CIPHER_CTX_set_key_length(ctx, client_hp.size());
-    // Passing an 1 means ENCRYPT
-    EVP_CipherInit_ex(ctx, NULL, NULL, client_hp.data(), NULL, 1);
 
     static_assert(AEAD_SAMPLE_LENGTH > 0);
     assert(all_data.size() >= encrypted_offset + MAXIMUM_PACKET_NUMBER_LENGTH + AEAD_SAMPLE_LENGTH);
@@ -102,7 +157,7 @@ DecryptionInformation remove_header_protection(const std::vector<uint8_t>& clien
     const uint8_t* sample = data_as_uint8(all_data) + encrypted_offset + MAXIMUM_PACKET_NUMBER_LENGTH;
 
     std::array<uint8_t, AEAD_SAMPLE_LENGTH> mask;
-    EVP_CipherUpdate(ctx, mask.data(), &outlen, sample, AEAD_SAMPLE_LENGTH);
+    EVP_CipherUpdate(hp_ctx, mask.data(), &outlen, sample, AEAD_SAMPLE_LENGTH);
 
     // To determine the actual packet number length,
     // we have to remove the mask from the first byte
@@ -151,8 +206,8 @@ std::vector<uint8_t> calculate_nonce(std::vector<uint8_t> client_iv, uint64_t pa
 /*
 Function that calls the AEAD decryption routine, and returns the decrypted data.
 */
-hilti::rt::Bytes decrypt(const std::vector<uint8_t>& client_key, const hilti::rt::Bytes& all_data,
-                         uint64_t payload_length, const DecryptionInformation& decryptInfo) {
+hilti::rt::Bytes decrypt(EVP_CIPHER_CTX* ctx, const hilti::rt::Bytes& all_data, uint64_t payload_length,
+                         const DecryptionInformation& decryptInfo) {
     int out, out2, res;
 
     if ( payload_length < decryptInfo.packet_number_length + AEAD_TAG_LENGTH )
@@ -175,16 +230,8 @@ hilti::rt::Bytes decrypt(const std::vector<uint8_t>& client_key, const hilti::rt
 
     std::array<uint8_t, MAXIMUM_PACKET_LENGTH> decrypt_buffer;
 
-    // Setup context
-    auto* ctx = get_aes_128_gcm();
-
-    // Set the sizes for the IV and KEY
-    EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_IVLEN, decryptInfo.nonce.size(), NULL);
-
-    EVP_CIPHER_CTX_set_key_length(ctx, client_key.size());
-
-    // Set the KEY and IV
-    EVP_CipherInit_ex(ctx, NULL, NULL, client_key.data(), decryptInfo.nonce.data(), 0);
+    // The context comes with the key already set, so only the IV changes.
+    EVP_CipherInit_ex(ctx, NULL, NULL, NULL, decryptInfo.nonce.data(), 0);
 
     // Set the tag to be validated after decryption
     EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_TAG, tag_to_check_length, const_cast<void*>(tag_to_check));
@@ -469,15 +516,20 @@ hilti::rt::Bytes QUIC_decrypt_crypto_payload(const hilti::rt::integer::safe<uint
         throw hilti::rt::RuntimeError(hilti::rt::fmt("unable to decrypt QUIC version 0x%lx", version));
     }
 
-    const auto& secret = qpp->GetSecret(from_client, v, connection_id);
-    std::vector<uint8_t> key = qpp->GetKey(secret);
-    std::vector<uint8_t> iv = qpp->GetIv(secret);
-    std::vector<uint8_t> hp = qpp->GetHp(secret);
+    static InitialKeysCache keys_cache;
+    auto index = InitialKeysCache::Index(v, from_client, connection_id);
+    auto* keys = keys_cache.Lookup(index);
+
+    if ( ! keys ) {
+        const auto& secret = qpp->GetSecret(from_client, v, connection_id);
+        auto new_keys = std::make_unique<InitialKeys>(qpp->GetKey(secret), qpp->GetIv(secret), qpp->GetHp(secret));
+        keys = keys_cache.Insert(std::move(index), std::move(new_keys));
+    }
 
-    DecryptionInformation decryptInfo = remove_header_protection(hp, encrypted_offset, all_data);
+    DecryptionInformation decryptInfo = remove_header_protection(keys->hp_ctx, encrypted_offset, all_data);
 
     // Calculate the correct nonce for the decryption
-    decryptInfo.nonce = calculate_nonce(iv, decryptInfo.packet_number);
+    decryptInfo.nonce = calculate_nonce(keys->iv, decryptInfo.packet_number);
 
-    return decrypt(key, all_data, payload_length, decryptInfo);
+    return decrypt(keys->aead_ctx, all_data, payload_length, decryptInfo);
 }
@@ -2,10 +2,55 @@
 
 #include "zeek/plugin/Plugin.h"
 
+#include "zeek/Conn.h"
+#include "zeek/Val.h"
+#include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/smb/SMB.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek::plugin::detail::Zeek_SMB {
 
+namespace {
+
+// Mirrors SMB::get_file_handle() in base/protocols/smb/files.zeek.
+std::optional<std::string> get_file_handle(const zeek::Tag& tag, zeek::Connection* c, bool is_orig) {
+    const auto& conn = c->GetVal();
+
+    if ( ! conn->HasField("smb_state") )
+        return std::nullopt;
+
+    auto smb_state = conn->GetField<zeek::RecordVal>("smb_state");
+
+    if ( ! smb_state->HasField("current_file") )
+        return "";
+
+    auto current_file = smb_state->GetField<zeek::RecordVal>("current_file");
+
+    if ( ! current_file->HasField("name") && ! current_file->HasField("path") )
+        return "";
+
+    auto empty = zeek::val_mgr->EmptyString();
+    auto path_name = current_file->HasField("path") ? current_file->GetField("path") : empty;
+    auto file_name = current_file->HasField("name") ? current_file->GetField("name") : empty;
+    zeek::ValPtr last_mod = zeek::val_mgr->Count(0);
+
+    if ( current_file->HasField("times") )
+        last_mod = current_file->GetField<zeek::RecordVal>("times")->GetField("modified_raw");
+
+    auto id = conn->GetField<zeek::RecordVal>("id");
+    auto handle = zeek::file_analysis::cat_vals(
+        {tag.AsVal(), id->GetField("orig_h"), id->GetField("resp_h"), path_name, file_name, last_mod});
+
+    // Same as clean().
+    zeek::String s(handle);
+    char* rendered = s.Render();
+    std::string result = rendered;
+    delete[] rendered;
+    return result;
+}
+
+} // namespace
+
 class Plugin : public zeek::plugin::Plugin {
 public:
     zeek::plugin::Configuration Configure() override {
@@ -17,6 +62,12 @@ public:
         config.description = "SMB analyzer";
         return config;
     }
+
+    void InitPostScript() override {
+        zeek::plugin::Plugin::InitPostScript();
+        zeek::file_mgr->RegisterFileHandleFunc(zeek::analyzer_mgr->GetComponentTag("SMB"), "SMB::get_file_handle",
+                                               get_file_handle);
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_SMB
@@ -2,12 +2,39 @@
 
 #include "zeek/plugin/Plugin.h"
 
+#include "zeek/Conn.h"
+#include "zeek/Val.h"
 #include "zeek/analyzer/Component.h"
+#include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/smtp/BDAT.h"
 #include "zeek/analyzer/protocol/smtp/SMTP.h"
+#include "zeek/file_analysis/Manager.h"
 
 namespace zeek::plugin::detail::Zeek_SMTP {
 
+namespace {
+
+// Mirrors SMTP::get_file_handle() in base/protocols/smtp/files.zeek.
+std::optional<std::string> get_file_handle(const zeek::Tag& tag, zeek::Connection* c, bool is_orig) {
+    const auto& conn = c->GetVal();
+
+    // Missing fields are runtime errors for the script version; let it
+    // report them.
+    if ( ! conn->HasField("smtp") || ! conn->HasField("smtp_state") )
+        return std::nullopt;
+
+    auto smtp = conn->GetField<zeek::RecordVal>("smtp");
+    auto smtp_state = conn->GetField<zeek::RecordVal>("smtp_state");
+
+    if ( ! smtp->HasField("trans_depth") )
+        return std::nullopt;
+
+    return zeek::file_analysis::cat_vals({tag.AsVal(), conn->GetField("start_time"), smtp->GetField("trans_depth"),
+                                          smtp_state->GetFieldOrDefault("mime_depth")});
+}
+
+} // namespace
+
 class Plugin : public zeek::plugin::Plugin {
 public:
     zeek::plugin::Configuration Configure() override {
@@ -19,6 +46,12 @@ public:
         config.description = "SMTP analyzer";
         return config;
     }
+
+    void InitPostScript() override {
+        zeek::plugin::Plugin::InitPostScript();
+        zeek::file_mgr->RegisterFileHandleFunc(zeek::analyzer_mgr->GetComponentTag("SMTP"), "SMTP::get_file_handle",
+                                               get_file_handle);
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_SMTP
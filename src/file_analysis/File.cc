@@ -6,6 +6,7 @@
 #include <utility>
 
 #include "zeek/Event.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/Reporter.h"
 #include "zeek/RuleMatcher.h"
 #include "zeek/Type.h"
@@ -86,6 +87,7 @@ File::File(const std::string& file_id, const std::string& source_name, Connectio
       reassembly_enabled(false),
       postpone_timeout(false),
       done(false),
+      ignored(false),
       analyzers(this) {
     StaticInit();
 
@@ -101,12 +103,17 @@ File::File(const std::string& file_id, const std::string& source_name, Connectio
     }
 
     UpdateLastActivityTime();
+
+    zeek::detail::memory_allocated(zeek::detail::MemoryTag::FileAnalysis, sizeof(File));
 }
 
 File::~File() {
     DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Destroying File object", id.c_str());
     delete file_reassembler;
 
+    zeek::detail::memory_freed(zeek::detail::MemoryTag::FileAnalysis,
+                               sizeof(File) + bof_buffer.size + bof_buffer.chunks.size() * sizeof(String));
+
     for ( auto a : done_analyzers )
         delete a;
 }
@@ -304,6 +311,7 @@ bool File::BufferBOF(const u_char* data, uint64_t len) {
 
     bof_buffer.chunks.push_back(new String(data, len, false));
     bof_buffer.size += len;
+    zeek::detail::memory_allocated(zeek::detail::MemoryTag::FileAnalysis, len + sizeof(String));
 
     if ( bof_buffer.size < desired_size )
         return true;
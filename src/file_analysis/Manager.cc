@@ -5,7 +5,10 @@
 #include <openssl/md5.h>
 
 #include "zeek/CompHash.h"
+#include "zeek/Desc.h"
 #include "zeek/Event.h"
+#include "zeek/Func.h"
+#include "zeek/ID.h"
 #include "zeek/UID.h"
 #include "zeek/analyzer/Manager.h"
 #include "zeek/digest.h"
@@ -31,8 +34,7 @@ Manager::~Manager() {
 
     // Have to assume that too much of Zeek has been shutdown by this point
     // to do anything more than reclaim memory.
-    for ( const auto& entry : id_map )
-        delete entry.second;
+    id_map.clear();
 
     delete magic_state;
     delete analyzer_hash;
@@ -138,6 +140,42 @@ string Manager::DataIn(const u_char* data, uint64_t len, const zeek::Tag& tag, C
     return id;
 }
 
+void Manager::DataIn(const u_char* data, uint64_t len, uint64_t offset, const zeek::Tag& tag, Connection* conn,
+                     bool is_orig, FileHandle& handle, const string& mime_type) {
+    File* file = GetFile(handle, conn, tag, is_orig, true);
+
+    if ( ! file )
+        return;
+
+    if ( ! mime_type.empty() )
+        file->SetMime(mime_type);
+
+    file->DataIn(data, len, offset);
+
+    if ( file->IsComplete() ) {
+        RemoveFile(file->GetID());
+        handle.Reset();
+    }
+}
+
+void Manager::DataIn(const u_char* data, uint64_t len, const zeek::Tag& tag, Connection* conn, bool is_orig,
+                     FileHandle& handle, const string& mime_type) {
+    File* file = GetFile(handle, conn, tag, is_orig, false);
+
+    if ( ! file )
+        return;
+
+    if ( ! mime_type.empty() )
+        file->SetMime(mime_type);
+
+    file->DataIn(data, len);
+
+    if ( file->IsComplete() ) {
+        RemoveFile(file->GetID());
+        handle.Reset();
+    }
+}
+
 void Manager::DataIn(const u_char* data, uint64_t len, const string& file_id, const string& source,
                      const string& mime_type) {
     File* file = GetFile(file_id, nullptr, zeek::Tag::Error, false, false, source.c_str());
@@ -194,6 +232,14 @@ string Manager::Gap(uint64_t offset, uint64_t len, const zeek::Tag& tag, Connect
     return id;
 }
 
+void Manager::Gap(uint64_t offset, uint64_t len, const zeek::Tag& tag, Connection* conn, bool is_orig,
+                  FileHandle& handle) {
+    File* file = GetFile(handle, conn, tag, is_orig, true);
+
+    if ( file )
+        file->Gap(offset, len);
+}
+
 string Manager::SetSize(uint64_t size, const zeek::Tag& tag, Connection* conn, bool is_orig,
                         const string& precomputed_id) {
     string id = precomputed_id.empty() ? GetFileID(tag, conn, is_orig) : precomputed_id;
@@ -212,6 +258,20 @@ string Manager::SetSize(uint64_t size, const zeek::Tag& tag, Connection* conn, b
     return id;
 }
 
+void Manager::SetSize(uint64_t size, const zeek::Tag& tag, Connection* conn, bool is_orig, FileHandle& handle) {
+    File* file = GetFile(handle, conn, tag, is_orig, true);
+
+    if ( ! file )
+        return;
+
+    file->SetTotalBytes(size);
+
+    if ( file->IsComplete() ) {
+        RemoveFile(file->GetID());
+        handle.Reset();
+    }
+}
+
 bool Manager::SetTimeoutInterval(const string& file_id, double interval) const {
     File* file = LookupFile(file_id);
 
@@ -293,8 +353,10 @@ File* Manager::GetFile(const string& file_id, Connection* conn, const zeek::Tag&
     File* rval = LookupFile(file_id);
 
     if ( ! rval ) {
-        rval = new File(file_id, source_name ? source_name : analyzer_mgr->GetComponentName(tag), conn, tag, is_orig);
-        id_map[file_id] = rval;
+        auto f = std::shared_ptr<File>(
+            new File(file_id, source_name ? source_name : analyzer_mgr->GetComponentName(tag), conn, tag, is_orig));
+        rval = f.get();
+        id_map[file_id] = std::move(f);
 
         ++cumulative_files;
         if ( id_map.size() > max_files )
@@ -321,12 +383,38 @@ File* Manager::GetFile(const string& file_id, Connection* conn, const zeek::Tag&
     return rval;
 }
 
+File* Manager::GetFile(FileHandle& handle, Connection* conn, const zeek::Tag& tag, bool is_orig, bool update_conn) {
+    if ( auto f = handle.file.lock(); f && ! f->ignored ) {
+        f->UpdateLastActivityTime();
+
+        if ( update_conn && f->UpdateConnectionFields(conn, is_orig) )
+            f->RaiseFileOverNewConnection(conn, is_orig);
+
+        return f.get();
+    }
+
+    if ( handle.id.empty() )
+        handle.id = GetFileID(tag, conn, is_orig);
+
+    File* rval = GetFile(handle.id, conn, tag, is_orig, update_conn);
+
+    if ( ! rval ) {
+        handle.Reset();
+        return nullptr;
+    }
+
+    if ( auto entry = id_map.find(handle.id); entry != id_map.end() )
+        handle.file = entry->second;
+
+    return rval;
+}
+
 File* Manager::LookupFile(const string& file_id) const {
     const auto& entry = id_map.find(file_id);
     if ( entry == id_map.end() )
         return nullptr;
 
-    return entry->second;
+    return entry->second.get();
 }
 
 void Manager::Timeout(const string& file_id, bool is_terminating) {
@@ -352,11 +440,15 @@ void Manager::Timeout(const string& file_id, bool is_terminating) {
 }
 
 bool Manager::IgnoreFile(const string& file_id) {
-    if ( ! LookupFile(file_id) )
+    File* f = LookupFile(file_id);
+
+    if ( ! f )
         return false;
 
     DBG_LOG(DBG_FILE_ANALYSIS, "Ignore FileID %s", file_id.c_str());
 
+    // File handles check the flag, so they don't need a lookup per chunk.
+    f->ignored = true;
     ignored.insert(file_id);
     return true;
 }
@@ -365,18 +457,20 @@ bool Manager::RemoveFile(const string& file_id) {
     // Can't remove from the dictionary/map right away as invoking EndOfFile
     // may cause some events to be executed which actually depend on the file
     // still being in the dictionary/map.
-    File* f = LookupFile(file_id);
+    auto entry = id_map.find(file_id);
 
-    if ( ! f )
+    if ( entry == id_map.end() )
         return false;
 
     DBG_LOG(DBG_FILE_ANALYSIS, "[%s] Remove file", file_id.c_str());
 
+    // Hold on to the File until we're done here, even if the script layer
+    // reentrantly removes it from the map.
+    auto f = entry->second;
     f->EndOfFile();
 
     id_map.erase(file_id);
     ignored.erase(file_id);
-    delete f;
     return true;
 }
 
@@ -391,6 +485,11 @@ string Manager::GetFileID(const zeek::Tag& tag, Connection* c, bool is_orig) {
     if ( ! get_file_handle )
         return "";
 
+    if ( auto handle = NativeFileHandle(tag, c, is_orig) ) {
+        SetHandle(*handle);
+        return current_file_id;
+    }
+
     DBG_LOG(DBG_FILE_ANALYSIS, "Raise get_file_handle() for protocol analyzer %s",
             analyzer_mgr->GetComponentName(tag).c_str());
 
@@ -401,6 +500,52 @@ string Manager::GetFileID(const zeek::Tag& tag, Connection* c, bool is_orig) {
     return current_file_id;
 }
 
+void Manager::RegisterFileHandleFunc(const zeek::Tag& tag, std::string_view script_func, FileHandleFunc func) {
+    const auto& id = zeek::id::find(script_func);
+
+    if ( ! id || ! id->GetVal() || ! IsFunc(id->GetType()->Tag()) )
+        return;
+
+    file_handle_funcs[tag] = {id->GetVal()->AsFunc(), std::move(func)};
+}
+
+std::optional<std::string> Manager::NativeFileHandle(const zeek::Tag& tag, Connection* c, bool is_orig) {
+    auto it = file_handle_funcs.find(tag);
+
+    if ( it == file_handle_funcs.end() )
+        return std::nullopt;
+
+    // Any get_file_handle handler beyond the file framework's own may
+    // set a different handle.
+    const auto& handler = get_file_handle->GetFunc();
+
+    if ( ! handler || handler->GetBodies().size() != 1 )
+        return std::nullopt;
+
+    // Keep raising the event when something observes it.
+    if ( new_event || plugin_mgr->HavePluginForHook(plugin::HOOK_QUEUE_EVENT) ||
+         plugin_mgr->HavePluginForHook(plugin::HOOK_CALL_FUNCTION) )
+        return std::nullopt;
+
+    static auto registered_protocols = id::find_val<TableVal>("Files::registered_protocols");
+
+    auto reg = registered_protocols->FindOrDefault(tag.AsVal());
+
+    if ( ! reg )
+        return std::nullopt;
+
+    auto f = reg->AsRecordVal()->GetField("get_file_handle");
+
+    if ( ! f || f->AsFunc() != it->second.script_func )
+        return std::nullopt;
+
+    // The handle depends on script-layer state that events still pending
+    // may update. Raising get_file_handle would process those first, too.
+    event_mgr.Drain();
+
+    return it->second.func(tag, c, is_orig);
+}
+
 bool Manager::IsDisabled(const zeek::Tag& tag) {
     if ( ! disabled )
         disabled = id::find_const("Files::disable")->AsTableVal();
@@ -470,6 +615,16 @@ string Manager::DetectMIME(const u_char* data, uint64_t len) const {
     return *(matches.begin()->second.begin());
 }
 
+std::string cat_vals(std::initializer_list<ValPtr> vals) {
+    ODesc d;
+    d.SetStyle(RAW_STYLE);
+
+    for ( const auto& v : vals )
+        v->Describe(&d);
+
+    return {reinterpret_cast<const char*>(d.Bytes()), static_cast<size_t>(d.Len())};
+}
+
 VectorValPtr GenMIMEMatchesVal(const zeek::detail::RuleMatcher::MIME_Matches& m) {
     static auto mime_matches = id::find_type<VectorType>("mime_matches");
     static auto mime_match = id::find_type<RecordType>("mime_match");
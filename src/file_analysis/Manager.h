@@ -2,7 +2,11 @@
 
 #pragma once
 
+#include <functional>
+#include <initializer_list>
 #include <map>
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -33,9 +37,51 @@ namespace detail {
 class CompositeHash;
 }
 
+class Func;
+class Val;
+using ValPtr = IntrusivePtr<Val>;
+
 namespace file_analysis {
 
 class File;
+class Manager;
+
+/**
+ * A resolved reference to a file being analyzed, for protocol analyzers
+ * that pass many chunks of the same file into the manager. It takes the
+ * place of the precomputed file ID string the other DataIn() variants
+ * accept: besides the ID, it remembers the File object the ID mapped to,
+ * so that subsequent calls don't need to look it up again. The handle does
+ * not keep the file alive. Once the file goes away, the manager falls back
+ * to the ID, exactly like with a precomputed ID.
+ *
+ * Data is always passed as a borrowed pointer. The file analysis framework
+ * only copies bytes that it needs to retain past the call (the BOF buffer
+ * and out-of-order chunks held by the reassembler).
+ */
+class FileHandle {
+public:
+    /**
+     * @return the file ID the handle refers to, or an empty string if it
+     *         has not been resolved yet or the file is no longer analyzed.
+     */
+    const std::string& ID() const { return id; }
+
+    /**
+     * Drops the reference, so that the next data delivered through the
+     * handle goes through a full file handle lookup again.
+     */
+    void Reset() {
+        id.clear();
+        file.reset();
+    }
+
+private:
+    friend class Manager;
+
+    std::string id;
+    std::weak_ptr<File> file;
+};
 
 /**
  * Main entry point for interacting with file analysis.
@@ -143,6 +189,41 @@ public:
     std::string DataIn(const u_char* data, uint64_t len, const zeek::Tag& tag, Connection* conn, bool is_orig,
                        const std::string& precomputed_file_id = "", const std::string& mime_type = "");
 
+    /**
+     * Pass in non-sequential file data through a file handle. Behaves like
+     * the variant taking a precomputed file ID but skips the ID lookup as
+     * long as the file the handle refers to is still being analyzed.
+     * @param data pointer to start of a chunk of file data.
+     * @param len number of bytes in the data chunk.
+     * @param offset number of bytes from start of file that data chunk occurs.
+     * @param tag network protocol over which the file data is transferred.
+     * @param conn network connection over which the file data is transferred.
+     * @param is_orig true if the file is being sent from connection originator
+     *        or false if is being sent in the opposite direction.
+     * @param handle the handle to deliver through; gets resolved on first
+     *        use and reset once the file is not going to be analyzed further.
+     * @param mime_type see the variant taking a precomputed file ID.
+     */
+    void DataIn(const u_char* data, uint64_t len, uint64_t offset, const zeek::Tag& tag, Connection* conn,
+                bool is_orig, FileHandle& handle, const std::string& mime_type = "");
+
+    /**
+     * Pass in sequential file data through a file handle. Behaves like the
+     * variant taking a precomputed file ID but skips the ID lookup as long
+     * as the file the handle refers to is still being analyzed.
+     * @param data pointer to start of a chunk of file data.
+     * @param len number of bytes in the data chunk.
+     * @param tag network protocol over which the file data is transferred.
+     * @param conn network connection over which the file data is transferred.
+     * @param is_orig true if the file is being sent from connection originator
+     *        or false if is being sent in the opposite direction.
+     * @param handle the handle to deliver through; gets resolved on first
+     *        use and reset once the file is not going to be analyzed further.
+     * @param mime_type see the variant taking a precomputed file ID.
+     */
+    void DataIn(const u_char* data, uint64_t len, const zeek::Tag& tag, Connection* conn, bool is_orig,
+                FileHandle& handle, const std::string& mime_type = "");
+
     /**
      * Pass in sequential file data from external source (e.g. input framework).
      * @param data pointer to start of a chunk of file data.
@@ -221,6 +302,12 @@ public:
     std::string Gap(uint64_t offset, uint64_t len, const zeek::Tag& tag, Connection* conn, bool is_orig,
                     const std::string& precomputed_file_id = "");
 
+    /**
+     * Signal a gap in the file data stream through a file handle.
+     * @see DataIn() for the handle semantics.
+     */
+    void Gap(uint64_t offset, uint64_t len, const zeek::Tag& tag, Connection* conn, bool is_orig, FileHandle& handle);
+
     /**
      * Provide the expected number of bytes that comprise a file.
      * @param size the number of bytes in the full file.
@@ -239,6 +326,13 @@ public:
     std::string SetSize(uint64_t size, const zeek::Tag& tag, Connection* conn, bool is_orig,
                         const std::string& precomputed_file_id = "");
 
+    /**
+     * Provide the expected number of bytes that comprise a file through a
+     * file handle.
+     * @see DataIn() for the handle semantics.
+     */
+    void SetSize(uint64_t size, const zeek::Tag& tag, Connection* conn, bool is_orig, FileHandle& handle);
+
     /**
      * Starts ignoring a file, which will finally be removed from internal
      * mappings on EOF or TIMEOUT.
@@ -364,6 +458,30 @@ public:
      */
     std::string GetFileID(const zeek::Tag& tag, Connection* c, bool is_orig);
 
+    /**
+     * A native implementation of a protocol's script-level
+     * \c get_file_handle function. It returns the file handle string, or
+     * std::nullopt to leave the decision to the script layer after all.
+     */
+    using FileHandleFunc = std::function<std::optional<std::string>(const zeek::Tag& tag, Connection* c, bool is_orig)>;
+
+    /**
+     * Registers a native equivalent of the script function that computes
+     * file handles for a protocol, so that GetFileID() can skip raising
+     * the \c get_file_handle event. The native function gets used only as
+     * long as \a script_func is what's registered for \a tag through
+     * \c Files::register_protocol() and no handlers other than the file
+     * framework's own exist for \c get_file_handle; as soon as a site
+     * customizes either, handles come from the script layer again. Must be
+     * called after scripts have been parsed, e.g. from a plugin's
+     * InitPostScript().
+     * @param tag the protocol analyzer tag.
+     * @param script_func name of the script function \a func mirrors. If it
+     *        doesn't exist, the registration is ignored.
+     * @param func the native implementation.
+     */
+    void RegisterFileHandleFunc(const zeek::Tag& tag, std::string_view script_func, FileHandleFunc func);
+
     uint64_t CurrentFiles() { return id_map.size(); }
 
     uint64_t MaxFiles() { return max_files; }
@@ -396,6 +514,16 @@ protected:
     File* GetFile(const std::string& file_id, Connection* conn = nullptr, const zeek::Tag& tag = zeek::Tag::Error,
                   bool is_orig = false, bool update_conn = true, const char* source_name = nullptr);
 
+    /**
+     * Returns the file a handle refers to, resolving the handle first if it
+     * isn't yet or the file it referred to is gone. Otherwise, this has the
+     * same effects as GetFile() with the handle's file ID.
+     * @return the File object, or a null pointer if analysis is being
+     *         ignored for the associated file, in which case the handle
+     *         gets reset.
+     */
+    File* GetFile(FileHandle& handle, Connection* conn, const zeek::Tag& tag, bool is_orig, bool update_conn);
+
     /**
      * Evaluate timeout policy for a file and remove the File object mapped to
      * \a file_id if needed.
@@ -428,11 +556,19 @@ private:
 
     TagSet* LookupMIMEType(const std::string& mtype, bool add_if_not_found);
 
-    std::map<std::string, File*> id_map;           /**< Map file ID to file_analysis::File records. */
-    std::set<std::string> ignored;                 /**< Ignored files.  Will be finally removed on EOF. */
-    std::string current_file_id;                   /**< Hash of what get_file_handle event sets. */
-    zeek::detail::RuleFileMagicState* magic_state; /**< File magic signature match state. */
-    MIMEMap mime_types;                            /**< Mapping of MIME types to analyzers. */
+    std::optional<std::string> NativeFileHandle(const zeek::Tag& tag, Connection* c, bool is_orig);
+
+    struct NativeFileHandleFunc {
+        const Func* script_func;
+        FileHandleFunc func;
+    };
+
+    std::map<std::string, std::shared_ptr<File>> id_map;   /**< Map file ID to file_analysis::File records. */
+    std::set<std::string> ignored;                         /**< Ignored files.  Will be finally removed on EOF. */
+    std::string current_file_id;                           /**< Hash of what get_file_handle event sets. */
+    zeek::detail::RuleFileMagicState* magic_state;         /**< File magic signature match state. */
+    MIMEMap mime_types;                                    /**< Mapping of MIME types to analyzers. */
+    std::map<Tag, NativeFileHandleFunc> file_handle_funcs; /**< Native get_file_handle equivalents. */
 
     inline static TableVal* disabled = nullptr;      /**< Table of disabled analyzers. */
     inline static TableType* tag_set_type = nullptr; /**< Type for set[tag]. */
@@ -443,6 +579,13 @@ private:
     zeek::detail::CompositeHash* analyzer_hash = nullptr;
 };
 
+/**
+ * Concatenates the script-layer representations of the given values, like
+ * the \c cat() BIF does. Intended for native file handle functions that
+ * mirror script code building handles with \c cat().
+ */
+std::string cat_vals(std::initializer_list<ValPtr> vals);
+
 /**
  * Returns a script-layer value corresponding to the \c mime_matches type.
  * @param m The MIME match information with which to populate the value.
@@ -27,6 +27,11 @@ Extract::Extract(RecordValPtr args, file_analysis::File* file, const std::string
             util::zeek_strerror_r(errno, buf, sizeof(buf));
             reporter->Warning("cannot set buffering mode for %s: %s", filename.data(), buf);
         }
+
+        if ( ExtractWriter::Get() ) {
+            sink = std::make_shared<ExtractWriter::Sink>(filename, file_stream);
+            file_stream = nullptr;
+        }
     }
     else {
         util::zeek_strerror_r(errno, buf, sizeof(buf));
@@ -35,6 +40,9 @@ Extract::Extract(RecordValPtr args, file_analysis::File* file, const std::string
 }
 
 Extract::~Extract() {
+    if ( sink )
+        ExtractWriter::Close(sink);
+
     if ( file_stream && fclose(file_stream) ) {
         char buf[128];
         util::zeek_strerror_r(errno, buf, sizeof(buf));
@@ -93,7 +101,10 @@ static bool check_limit_exceeded(uint64_t lim, uint64_t written, uint64_t len, u
 }
 
 bool Extract::DeliverStream(const u_char* data, uint64_t len) {
-    if ( ! file_stream )
+    if ( sink && sink->Failed() )
+        sink.reset();
+
+    if ( ! file_stream && ! sink )
         return false;
 
     uint64_t towrite = 0;
@@ -110,7 +121,9 @@ bool Extract::DeliverStream(const u_char* data, uint64_t len) {
     char buf[128];
 
     if ( towrite > 0 ) {
-        if ( fwrite(data, towrite, 1, file_stream) != 1 ) {
+        if ( sink )
+            ExtractWriter::Write(sink, data, towrite);
+        else if ( fwrite(data, towrite, 1, file_stream) != 1 ) {
             util::zeek_strerror_r(errno, buf, sizeof(buf));
             reporter->Error("failed to write to extracted file %s: %s", filename.data(), buf);
             fclose(file_stream);
@@ -125,16 +138,42 @@ bool Extract::DeliverStream(const u_char* data, uint64_t len) {
     // the extraction limit and the file analysis File still proceeding to
     // do other analysis without destructing/closing this one until the very end,
     // so flush anything currently buffered.
-    if ( limit_exceeded && fflush(file_stream) ) {
+    if ( limit_exceeded ) {
+        if ( sink )
+            ExtractWriter::Flush(sink);
+        else if ( fflush(file_stream) ) {
+            util::zeek_strerror_r(errno, buf, sizeof(buf));
+            reporter->Warning("cannot fflush extracted file %s: %s", filename.data(), buf);
+        }
+    }
+
+    return (! limit_exceeded);
+}
+
+bool Extract::EndOfFile() {
+    if ( sink && sink->Failed() )
+        sink.reset();
+
+    if ( sink ) {
+        // The writer thread completes the file, without stalling the
+        // main thread on the disk.
+        ExtractWriter::Close(sink);
+        sink.reset();
+    }
+    else if ( file_stream && fflush(file_stream) ) {
+        char buf[128];
         util::zeek_strerror_r(errno, buf, sizeof(buf));
         reporter->Warning("cannot fflush extracted file %s: %s", filename.data(), buf);
     }
 
-    return (! limit_exceeded);
+    return true;
 }
 
 bool Extract::Undelivered(uint64_t offset, uint64_t len) {
-    if ( ! file_stream )
+    if ( sink && sink->Failed() )
+        sink.reset();
+
+    if ( ! file_stream && ! sink )
         return false;
 
     if ( limit_includes_missing ) {
@@ -157,6 +196,11 @@ bool Extract::Undelivered(uint64_t offset, uint64_t len) {
         written += len;
     }
 
+    if ( sink ) {
+        ExtractWriter::Seek(sink, len + offset);
+        return true;
+    }
+
     if ( fseek(file_stream, len + offset, SEEK_SET) != 0 ) {
         char buf[128];
         util::zeek_strerror_r(errno, buf, sizeof(buf));
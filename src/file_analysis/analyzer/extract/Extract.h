@@ -8,6 +8,7 @@
 #include "zeek/Val.h"
 #include "zeek/file_analysis/Analyzer.h"
 #include "zeek/file_analysis/File.h"
+#include "zeek/file_analysis/analyzer/extract/ExtractWriter.h"
 #include "zeek/file_analysis/analyzer/extract/events.bif.h"
 
 namespace zeek::file_analysis::detail {
@@ -39,6 +40,13 @@ public:
      */
     bool Undelivered(uint64_t offset, uint64_t len) override;
 
+    /**
+     * Flushes the extraction file. When writing asynchronously, this only
+     * hands the file's close to the writer thread.
+     * @return true
+     */
+    bool EndOfFile() override;
+
     /**
      * Create a new instance of an Extract analyzer.
      * @param args the \c AnalyzerArgs value which represents the analyzer.
@@ -71,6 +79,7 @@ protected:
 private:
     std::string filename;
     FILE* file_stream;
+    ExtractWriter::SinkPtr sink; // set instead of file_stream if writing asynchronously
     uint64_t limit;              // the file extraction limit
     uint64_t written;            // how many bytes we have written so far
     bool limit_includes_missing; // do count missing bytes against limit if true
@@ -0,0 +1,216 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/file_analysis/analyzer/extract/ExtractWriter.h"
+
+#include "zeek/Reporter.h"
+#include "zeek/util.h"
+
+#include "zeek/file_analysis/analyzer/extract/consts.bif.h"
+
+namespace zeek::file_analysis::detail {
+
+// Amount of data collected for a file before it's handed to the writer.
+static constexpr size_t BUFFER_BYTES = 64 * 1024;
+
+std::unique_ptr<ExtractWriter> ExtractWriter::instance;
+bool ExtractWriter::terminated = false;
+
+ExtractWriter* ExtractWriter::Get() {
+    if ( ! instance && ! terminated && BifConst::FileExtract::async_max_pending > 0 )
+        instance.reset(new ExtractWriter(BifConst::FileExtract::async_max_pending));
+
+    return instance.get();
+}
+
+void ExtractWriter::Terminate() {
+    instance.reset();
+    terminated = true;
+}
+
+ExtractWriter::ExtractWriter(uint64_t arg_max_pending) : max_pending(arg_max_pending) {
+    thread = std::thread([this]() {
+        util::detail::set_thread_name("zeek.extract");
+        Run();
+    });
+}
+
+ExtractWriter::~ExtractWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+
+    work_cv.notify_one();
+    thread.join();
+
+    ReportErrors();
+}
+
+void ExtractWriter::Write(const SinkPtr& sink, const u_char* data, uint64_t len) {
+    sink->buffer.insert(sink->buffer.end(), data, data + len);
+
+    if ( sink->buffer.size() >= BUFFER_BYTES || ! instance )
+        SubmitBuffer(sink);
+}
+
+void ExtractWriter::Seek(const SinkPtr& sink, uint64_t pos) {
+    SubmitBuffer(sink);
+
+    Op op{Op::SEEK, sink};
+    op.pos = pos;
+    Submit(std::move(op));
+}
+
+void ExtractWriter::Flush(const SinkPtr& sink) {
+    SubmitBuffer(sink);
+    Submit(Op{Op::FLUSH, sink});
+}
+
+void ExtractWriter::Close(const SinkPtr& sink) {
+    SubmitBuffer(sink);
+    Submit(Op{Op::CLOSE, sink});
+}
+
+void ExtractWriter::SubmitBuffer(const SinkPtr& sink) {
+    if ( sink->buffer.empty() )
+        return;
+
+    Op op{Op::WRITE, sink};
+    op.data.swap(sink->buffer);
+    Submit(std::move(op));
+}
+
+void ExtractWriter::Submit(Op op) {
+    if ( instance ) {
+        instance->Enqueue(std::move(op));
+        return;
+    }
+
+    Error err;
+
+    if ( ! Apply(op, &err) )
+        Report(err);
+}
+
+bool ExtractWriter::Apply(Op& op, Error* err) {
+    auto& sink = *op.sink;
+
+    if ( ! sink.stream )
+        return true;
+
+    char buf[128];
+    char msg[512];
+
+    switch ( op.kind ) {
+        case Op::WRITE:
+            if ( fwrite(op.data.data(), op.data.size(), 1, sink.stream) == 1 )
+                return true;
+
+            util::zeek_strerror_r(errno, buf, sizeof(buf));
+            snprintf(msg, sizeof(msg), "failed to write to extracted file %s: %s", sink.filename.data(), buf);
+            break;
+
+        case Op::SEEK:
+            if ( fseek(sink.stream, op.pos, SEEK_SET) == 0 )
+                return true;
+
+            util::zeek_strerror_r(errno, buf, sizeof(buf));
+            snprintf(msg, sizeof(msg), "failed to seek in extracted file %s: %s", sink.filename.data(), buf);
+            break;
+
+        case Op::FLUSH:
+            if ( fflush(sink.stream) == 0 )
+                return true;
+
+            util::zeek_strerror_r(errno, buf, sizeof(buf));
+            snprintf(msg, sizeof(msg), "cannot fflush extracted file %s: %s", sink.filename.data(), buf);
+            *err = {true, msg};
+            return false;
+
+        case Op::CLOSE: {
+            int rc = fclose(sink.stream);
+            sink.stream = nullptr;
+
+            if ( rc == 0 )
+                return true;
+
+            util::zeek_strerror_r(errno, buf, sizeof(buf));
+            snprintf(msg, sizeof(msg), "cannot close %s: %s", sink.filename.data(), buf);
+            *err = {false, msg};
+            return false;
+        }
+    }
+
+    // A failed write or seek leaves the file unusable.
+    fclose(sink.stream);
+    sink.stream = nullptr;
+    sink.failed.store(true, std::memory_order_release);
+
+    *err = {false, msg};
+    return false;
+}
+
+void ExtractWriter::Report(const Error& err) {
+    if ( err.warning )
+        reporter->Warning("%s", err.msg.c_str());
+    else
+        reporter->Error("%s", err.msg.c_str());
+}
+
+void ExtractWriter::Enqueue(Op op) {
+    ReportErrors();
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // Apply backpressure if the disk can't keep up.
+    done_cv.wait(lock, [this]() { return pending_bytes < max_pending || ops.empty(); });
+
+    pending_bytes += op.data.size();
+    ops.push_back(std::move(op));
+    work_cv.notify_one();
+}
+
+void ExtractWriter::ReportErrors() {
+    std::vector<Error> pending_errors;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending_errors.swap(errors);
+    }
+
+    for ( const auto& err : pending_errors )
+        Report(err);
+}
+
+void ExtractWriter::Run() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while ( true ) {
+        work_cv.wait(lock, [this]() { return stopping || ! ops.empty(); });
+
+        if ( ops.empty() )
+            return;
+
+        Op op = std::move(ops.front());
+        ops.pop_front();
+
+        lock.unlock();
+
+        Error err;
+        bool ok = Apply(op, &err);
+        auto len = op.data.size();
+
+        // Release the sink outside of the lock.
+        op.sink.reset();
+
+        lock.lock();
+
+        if ( ! ok )
+            errors.push_back(std::move(err));
+
+        pending_bytes -= len;
+        done_cv.notify_all();
+    }
+}
+
+} // namespace zeek::file_analysis::detail
@@ -0,0 +1,139 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <sys/types.h> // for u_char
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zeek::file_analysis::detail {
+
+/**
+ * A background thread performing the disk I/O of the extraction analyzer,
+ * used if FileExtract::async_max_pending is non-zero.
+ *
+ * Writes get collected in a per-file buffer on the main thread and are
+ * queued for the writer thread once the buffer fills up, or when a seek,
+ * flush or close requires them to go out. All operations run on a single
+ * thread in submission order. If more than FileExtract::async_max_pending
+ * bytes are waiting to be written, the main thread blocks until the writer
+ * catches up.
+ *
+ * The final flush and close of a file are handed to the thread as well, so
+ * a file may not be complete on disk yet when scripts learn about its end.
+ *
+ * Errors of the writer thread are reported from the main thread the next
+ * time an extraction file is accessed, and at termination. A Sink that has
+ * failed is closed, which the analyzer notices through Sink::Failed().
+ *
+ * Once the writer has terminated, all operations run synchronously on the
+ * calling thread.
+ */
+class ExtractWriter {
+public:
+    /**
+     * An extraction file handed over to the writer.
+     */
+    class Sink {
+    public:
+        Sink(std::string arg_filename, FILE* arg_stream) : filename(std::move(arg_filename)), stream(arg_stream) {}
+
+        /**
+         * @return true if an operation on the file failed and it has been
+         * closed.
+         */
+        bool Failed() const { return failed.load(std::memory_order_acquire); }
+
+    private:
+        friend class ExtractWriter;
+
+        std::string filename;
+        FILE* stream;                    /**< Only used by the thread performing the I/O. */
+        std::vector<u_char> buffer;      /**< Pending writes, main thread only. */
+        std::atomic<bool> failed{false}; /**< Set once the stream was closed due to an error. */
+    };
+
+    using SinkPtr = std::shared_ptr<Sink>;
+
+    /**
+     * @return the writer, starting its thread on first use, or null if
+     * FileExtract::async_max_pending is zero and writes are synchronous.
+     */
+    static ExtractWriter* Get();
+
+    /**
+     * Completes all pending operations, reports their errors, and stops the
+     * writer thread.
+     */
+    static void Terminate();
+
+    ~ExtractWriter();
+
+    /**
+     * Appends data to a file.
+     */
+    static void Write(const SinkPtr& sink, const u_char* data, uint64_t len);
+
+    /**
+     * Sets the position in a file at which subsequent data gets written.
+     */
+    static void Seek(const SinkPtr& sink, uint64_t pos);
+
+    /**
+     * Flushes a file's buffers to disk.
+     */
+    static void Flush(const SinkPtr& sink);
+
+    /**
+     * Closes a file. The sink must not be used afterwards.
+     */
+    static void Close(const SinkPtr& sink);
+
+private:
+    struct Op {
+        enum Kind { WRITE, SEEK, FLUSH, CLOSE } kind;
+        SinkPtr sink;
+        std::vector<u_char> data; /**< For WRITE. */
+        uint64_t pos = 0;         /**< For SEEK. */
+    };
+
+    struct Error {
+        bool warning;
+        std::string msg;
+    };
+
+    explicit ExtractWriter(uint64_t max_pending);
+
+    static void SubmitBuffer(const SinkPtr& sink);
+    static void Submit(Op op);
+    static bool Apply(Op& op, Error* err);
+    static void Report(const Error& err);
+
+    void Enqueue(Op op);
+    void ReportErrors();
+    void Run();
+
+    uint64_t max_pending;
+
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    std::deque<Op> ops;
+    uint64_t pending_bytes = 0;
+    std::vector<Error> errors;
+    bool stopping = false;
+    std::thread thread;
+
+    static std::unique_ptr<ExtractWriter> instance;
+    static bool terminated;
+};
+
+} // namespace zeek::file_analysis::detail
@@ -4,6 +4,7 @@
 
 #include "zeek/file_analysis/Component.h"
 #include "zeek/file_analysis/analyzer/extract/Extract.h"
+#include "zeek/file_analysis/analyzer/extract/ExtractWriter.h"
 
 namespace zeek::plugin::detail::Zeek_FileExtract {
 
@@ -17,6 +18,11 @@ public:
         config.description = "Extract file content";
         return config;
     }
+
+    void Done() override {
+        zeek::plugin::Plugin::Done();
+        zeek::file_analysis::detail::ExtractWriter::Terminate();
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_FileExtract
@@ -21,9 +21,17 @@ Hash::Hash(RecordValPtr args, file_analysis::File* file, HashVal* hv, StringValP
       fed(false),
       kind(std::move(arg_kind)) {
     hash->Init();
+
+    if ( HashPool::Get() )
+        stream = std::make_unique<HashPool::Stream>(hash);
 }
 
-Hash::~Hash() { Unref(hash); }
+Hash::~Hash() {
+    if ( stream )
+        HashPool::Wait(stream.get());
+
+    Unref(hash);
+}
 
 bool Hash::DeliverStream(const u_char* data, uint64_t len) {
     if ( ! hash->IsValid() )
@@ -32,7 +40,21 @@ bool Hash::DeliverStream(const u_char* data, uint64_t len) {
     if ( ! fed )
         fed = len > 0;
 
-    hash->Feed(data, len);
+    if ( ! stream )
+        hash->Feed(data, len);
+
+    else if ( auto* pool = HashPool::Get() ) {
+        if ( len > 0 )
+            pool->Submit(stream.get(), pool->Share(GetFile(), offset, data, len));
+    }
+
+    else {
+        // The pool has been shut down; catch up on anything still pending.
+        HashPool::Wait(stream.get());
+        hash->Feed(data, len);
+    }
+
+    offset += len;
     return true;
 }
 
@@ -50,6 +72,9 @@ void Hash::Finalize() {
     if ( ! file_hash )
         return;
 
+    if ( stream )
+        HashPool::Wait(stream.get());
+
     event_mgr.Enqueue(file_hash, GetFile()->ToVal(), kind, hash->Get());
 }
 
@@ -2,12 +2,14 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "zeek/OpaqueVal.h"
 #include "zeek/Val.h"
 #include "zeek/file_analysis/Analyzer.h"
 #include "zeek/file_analysis/File.h"
+#include "zeek/file_analysis/analyzer/hash/HashPool.h"
 #include "zeek/file_analysis/analyzer/hash/events.bif.h"
 
 namespace zeek::file_analysis::detail {
@@ -65,6 +67,8 @@ private:
     HashVal* hash;
     bool fed;
     StringValPtr kind;
+    std::unique_ptr<HashPool::Stream> stream; /**< Set if hashing on worker threads. */
+    uint64_t offset = 0;                      /**< Stream offset of the next chunk. */
 };
 
 /**
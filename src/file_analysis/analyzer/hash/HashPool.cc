@@ -0,0 +1,148 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/file_analysis/analyzer/hash/HashPool.h"
+
+#include <cstring>
+
+#include "zeek/OpaqueVal.h"
+#include "zeek/util.h"
+
+#include "zeek/file_analysis/analyzer/hash/consts.bif.h"
+
+namespace zeek::file_analysis::detail {
+
+std::unique_ptr<HashPool> HashPool::instance;
+bool HashPool::terminated = false;
+
+HashPool* HashPool::Get() {
+    if ( ! instance && ! terminated && BifConst::FileHash::worker_threads > 0 )
+        instance.reset(new HashPool(BifConst::FileHash::worker_threads));
+
+    return instance.get();
+}
+
+void HashPool::Terminate() {
+    instance.reset();
+    terminated = true;
+}
+
+HashPool::HashPool(int num_threads) {
+    for ( int i = 0; i < num_threads; ++i )
+        threads.emplace_back([this]() {
+            util::detail::set_thread_name("zeek.hash");
+            Run();
+        });
+}
+
+HashPool::~HashPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+
+    work_cv.notify_all();
+
+    for ( auto& t : threads )
+        t.join();
+}
+
+HashPool::Chunk HashPool::Share(const File* file, uint64_t offset, const u_char* data, uint64_t len) {
+    // The buffer may have been reused since, so compare the contents too.
+    if ( last_chunk && file == last_file && offset == last_offset && data == last_data && len == last_chunk->size() &&
+         memcmp(data, last_chunk->data(), len) == 0 )
+        return last_chunk;
+
+    last_file = file;
+    last_offset = offset;
+    last_data = data;
+    last_chunk = std::make_shared<const std::vector<u_char>>(data, data + len);
+    return last_chunk;
+}
+
+void HashPool::Submit(Stream* s, Chunk c) {
+    s->current_bytes += c->size();
+    s->current.push_back(std::move(c));
+
+    if ( s->current_bytes >= BifConst::FileHash::batch_size )
+        Flush(s);
+}
+
+void HashPool::Flush(Stream* s) {
+    if ( s->current.empty() )
+        return;
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // Apply backpressure if the workers can't keep up.
+    done_cv.wait(lock, [this]() { return queued_bytes == 0 || queued_bytes < BifConst::FileHash::max_queued; });
+
+    queued_bytes += s->current_bytes;
+    s->queued.push_back(std::move(s->current));
+    s->current.clear();
+    s->current_bytes = 0;
+
+    if ( ! s->scheduled ) {
+        s->scheduled = true;
+        ready.push_back(s);
+        work_cv.notify_one();
+    }
+}
+
+void HashPool::Wait(Stream* s) {
+    if ( ! instance ) {
+        // Workers are gone, which means they have drained everything
+        // that was queued already.
+        for ( const auto& c : s->current )
+            s->hash->Feed(c->data(), c->size());
+
+        s->current.clear();
+        s->current_bytes = 0;
+        return;
+    }
+
+    instance->Flush(s);
+
+    std::unique_lock<std::mutex> lock(instance->mtx);
+    instance->done_cv.wait(lock, [s]() { return ! s->scheduled; });
+}
+
+void HashPool::Run() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while ( true ) {
+        work_cv.wait(lock, [this]() { return stopping || ! ready.empty(); });
+
+        if ( ready.empty() )
+            return;
+
+        Stream* s = ready.front();
+        ready.pop_front();
+
+        auto batches = std::move(s->queued);
+        s->queued.clear();
+
+        lock.unlock();
+
+        uint64_t bytes = 0;
+
+        for ( const auto& batch : batches ) {
+            for ( const auto& c : batch ) {
+                s->hash->Feed(c->data(), c->size());
+                bytes += c->size();
+            }
+        }
+
+        lock.lock();
+
+        queued_bytes -= bytes;
+
+        if ( s->queued.empty() )
+            s->scheduled = false;
+        else
+            ready.push_back(s);
+
+        done_cv.notify_all();
+    }
+}
+
+} // namespace zeek::file_analysis::detail
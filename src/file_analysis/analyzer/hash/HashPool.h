@@ -0,0 +1,125 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <sys/types.h> // for u_char
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zeek {
+
+class HashVal;
+
+namespace file_analysis {
+
+class File;
+
+namespace detail {
+
+/**
+ * A small pool of worker threads that feeds file contents into hash states
+ * off the main thread, used by the hash analyzers if
+ * FileHash::worker_threads is non-zero.
+ *
+ * Each hash analyzer owns a Stream. Chunks submitted to it are collected
+ * into batches on the main thread and handed to the workers once large
+ * enough, so that synchronization is amortized across many packets. A
+ * Stream is only ever worked on by one thread at a time, which keeps its
+ * chunks in order. Wait() blocks until a Stream has been fed completely;
+ * the analyzers call it before retrieving the digest, so file_hash is
+ * still raised from EndOfFile() ahead of file_state_remove.
+ */
+class HashPool {
+public:
+    using Chunk = std::shared_ptr<const std::vector<u_char>>;
+
+    /**
+     * The sequence of chunks to feed into one hash state.
+     */
+    class Stream {
+    public:
+        explicit Stream(HashVal* arg_hash) : hash(arg_hash) {}
+
+    private:
+        friend class HashPool;
+
+        HashVal* hash;
+
+        // Main thread only.
+        std::vector<Chunk> current;
+        uint64_t current_bytes = 0;
+
+        // Guarded by the pool's mutex.
+        std::deque<std::vector<Chunk>> queued;
+        bool scheduled = false;
+    };
+
+    /**
+     * @return the pool, starting its threads on first use, or null if
+     * FileHash::worker_threads is zero and hashing is synchronous.
+     */
+    static HashPool* Get();
+
+    /**
+     * Waits for outstanding work and stops the worker threads. Streams
+     * used afterwards get fed on the calling thread.
+     */
+    static void Terminate();
+
+    ~HashPool();
+
+    /**
+     * Returns a reference-counted copy of a chunk of file data. All hash
+     * analyzers attached to a file receive the same chunks, so consecutive
+     * requests for the same chunk share a single copy.
+     * @param file the file the data belongs to.
+     * @param offset the stream offset of the data within the file.
+     * @param data the data.
+     * @param len the data's length.
+     */
+    Chunk Share(const File* file, uint64_t offset, const u_char* data, uint64_t len);
+
+    /**
+     * Appends a chunk to a stream. The stream's current batch gets handed
+     * to the workers once it exceeds the batch size.
+     */
+    void Submit(Stream* s, Chunk c);
+
+    /**
+     * Blocks until all chunks submitted to a stream have been fed into its
+     * hash state.
+     */
+    static void Wait(Stream* s);
+
+private:
+    explicit HashPool(int num_threads);
+
+    void Flush(Stream* s);
+    void Run();
+
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    std::deque<Stream*> ready;
+    uint64_t queued_bytes = 0;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    // The chunk most recently handed out by Share().
+    const File* last_file = nullptr;
+    uint64_t last_offset = 0;
+    const u_char* last_data = nullptr;
+    Chunk last_chunk;
+
+    static std::unique_ptr<HashPool> instance;
+    static bool terminated;
+};
+
+} // namespace detail
+} // namespace file_analysis
+} // namespace zeek
@@ -4,6 +4,7 @@
 
 #include "zeek/file_analysis/Component.h"
 #include "zeek/file_analysis/analyzer/hash/Hash.h"
+#include "zeek/file_analysis/analyzer/hash/HashPool.h"
 
 namespace zeek::plugin::detail::Zeek_FileHash {
 
@@ -19,6 +20,11 @@ public:
         config.description = "Hash file content";
         return config;
     }
+
+    void Done() override {
+        zeek::plugin::Plugin::Done();
+        zeek::file_analysis::detail::HashPool::Terminate();
+    }
 } plugin;
 
 } // namespace zeek::plugin::detail::Zeek_FileHash
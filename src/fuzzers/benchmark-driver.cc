@@ -0,0 +1,172 @@
+// Driver replaying inputs through a fuzz target repeatedly to measure its
+// throughput. It links with the same fuzz target sources as the standalone
+// driver, see the README for usage.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "zeek/zeek-setup.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+
+// Allocations through operator new, counted by the replacements below.
+// This doesn't cover direct calls to malloc().
+static std::atomic<uint64_t> num_allocations{0};
+static std::atomic<uint64_t> allocated_bytes{0};
+
+void* operator new(size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if ( auto* p = malloc(size ? size : 1) )
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Input {
+    std::string name;
+    std::vector<uint8_t> data;
+
+    // Totals across all iterations.
+    double seconds = 0.0;
+    uint64_t allocations = 0;
+    uint64_t allocated = 0;
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [-n iterations] [-v] <input file or directory>... [-- <zeek options>]\n", prog);
+    exit(1);
+}
+
+static void load_input(const std::filesystem::path& path, std::vector<Input>* inputs) {
+    std::ifstream f(path, std::ios::binary);
+
+    if ( ! f ) {
+        fprintf(stderr, "failed to open %s: %s\n", path.c_str(), strerror(errno));
+        exit(1);
+    }
+
+    Input input;
+    input.name = path.string();
+    input.data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    inputs->push_back(std::move(input));
+}
+
+// Loads a file, or all files in a directory in the order of their names.
+static void load_inputs(const std::filesystem::path& path, std::vector<Input>* inputs) {
+    if ( ! std::filesystem::is_directory(path) ) {
+        load_input(path, inputs);
+        return;
+    }
+
+    std::vector<std::filesystem::path> files;
+
+    for ( const auto& entry : std::filesystem::directory_iterator(path) )
+        if ( entry.is_regular_file() )
+            files.push_back(entry.path());
+
+    std::sort(files.begin(), files.end());
+
+    for ( const auto& file : files )
+        load_input(file, inputs);
+}
+
+int main(int argc, char** argv) {
+    using namespace std::chrono;
+
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    int iterations = 1000;
+    bool verbose = false;
+    std::vector<Input> inputs;
+
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp(argv[i], "-n") == 0 ) {
+            if ( ++i == argc )
+                usage(argv[0]);
+
+            iterations = atoi(argv[i]);
+
+            if ( iterations <= 0 )
+                usage(argv[0]);
+        }
+        else if ( strcmp(argv[i], "-v") == 0 )
+            verbose = true;
+        else
+            load_inputs(argv[i], &inputs);
+    }
+
+    if ( inputs.empty() )
+        usage(argv[0]);
+
+    uint64_t total_bytes = 0;
+
+    // One warm-up pass so that one-time initialization, like compiling
+    // regular expressions on first use, doesn't count.
+    for ( const auto& input : inputs ) {
+        LLVMFuzzerTestOneInput(input.data.data(), input.data.size());
+        total_bytes += input.data.size();
+    }
+
+    printf("Benchmarking %zu inputs (%" PRIu64 " bytes), %d iterations\n", inputs.size(), total_bytes, iterations);
+    fflush(stdout);
+
+    for ( int i = 0; i < iterations; ++i ) {
+        for ( auto& input : inputs ) {
+            auto allocations_start = num_allocations.load(std::memory_order_relaxed);
+            auto allocated_start = allocated_bytes.load(std::memory_order_relaxed);
+            auto start = steady_clock::now();
+
+            LLVMFuzzerTestOneInput(input.data.data(), input.data.size());
+
+            auto stop = steady_clock::now();
+            input.seconds += duration<double>(stop - start).count();
+            input.allocations += num_allocations.load(std::memory_order_relaxed) - allocations_start;
+            input.allocated += allocated_bytes.load(std::memory_order_relaxed) - allocated_start;
+        }
+    }
+
+    double total_seconds = 0.0;
+    uint64_t total_allocations = 0;
+    uint64_t total_allocated = 0;
+
+    for ( const auto& input : inputs ) {
+        total_seconds += input.seconds;
+        total_allocations += input.allocations;
+        total_allocated += input.allocated;
+
+        if ( verbose )
+            printf("  %s: %zu bytes, %.1f us, %.2f MB/s, %.1f allocations (%.0f bytes)\n", input.name.c_str(),
+                   input.data.size(), input.seconds / iterations * 1e6,
+                   input.data.size() * iterations / input.seconds / 1e6,
+                   static_cast<double>(input.allocations) / iterations,
+                   static_cast<double>(input.allocated) / iterations);
+    }
+
+    double runs = static_cast<double>(inputs.size()) * iterations;
+
+    printf("Processed %.0f inputs in %fs\n", runs, total_seconds);
+    printf("  throughput:  %.2f MB/s, %.0f inputs/s\n", total_bytes * iterations / total_seconds / 1e6,
+           runs / total_seconds);
+    printf("  allocations: %.1f per input, %.0f bytes per input\n", total_allocations / runs, total_allocated / runs);
+
+    return zeek::detail::cleanup(false);
+}
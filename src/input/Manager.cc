@@ -18,6 +18,7 @@
 #include "zeek/input/ReaderFrontend.h"
 #include "zeek/input/input.bif.h"
 #include "zeek/module_util.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/threading/SerialTypes.h"
 
 using namespace std;
@@ -96,6 +97,9 @@ public:
 
     EventHandlerPtr event;
 
+    // Main-thread time spent on the current update so far.
+    double update_time = 0.0;
+
     TableStream();
     ~TableStream() override;
 };
@@ -688,7 +692,7 @@ bool Manager::CreateTableStream(RecordVal* fval) {
     stream->want_record = (want_record->InternalInt() == 1);
 
     assert(stream->reader);
-    stream->reader->Init(fieldsV.size(), fields);
+    stream->reader->Init(fieldsV.size(), fields, idxfields);
 
     readers[stream->reader] = stream;
 
@@ -1054,8 +1058,11 @@ void Manager::SendEntry(ReaderFrontend* reader, Value** vals) {
 
     int readFields = 0;
 
-    if ( i->stream_type == TABLE_STREAM )
+    if ( i->stream_type == TABLE_STREAM ) {
+        double start = util::current_time(true);
         readFields = SendEntryTable(i, vals);
+        static_cast<TableStream*>(i)->update_time += util::current_time(true) - start;
+    }
 
     else if ( i->stream_type == EVENT_STREAM ) {
         auto type = BifType::Enum::Input::Event->GetEnumVal(BifEnum::Input::EVENT_NEW);
@@ -1075,9 +1082,58 @@ void Manager::SendEntry(ReaderFrontend* reader, Value** vals) {
     Value::delete_value_ptr_array(vals, readFields);
 }
 
-int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
-    bool updated = false;
+void Manager::SendEntry(ReaderFrontend* reader, const HashedEntry& entry) {
+    Stream* i = FindStream(reader);
+    if ( i == nullptr ) {
+        reporter->InternalWarning("Unknown reader %s in SendEntry", reader->Name());
+        delete entry.idxhash;
+        return;
+    }
+
+    if ( i->stream_type != TABLE_STREAM ) {
+        delete entry.idxhash;
+        SendEntry(reader, entry.vals);
+        return;
+    }
+
+    double start = util::current_time(true);
+    int readFields = SendEntryTable(i, entry.vals, entry.idxhash, entry.valhash);
+    Value::delete_value_ptr_array(entry.vals, readFields);
+    static_cast<TableStream*>(i)->update_time += util::current_time(true) - start;
+}
+
+void Manager::SendEntries(ReaderFrontend* reader, const std::vector<HashedEntry>& entries) {
+    Stream* i = FindStream(reader);
+    if ( i == nullptr ) {
+        reporter->InternalWarning("Unknown reader %s in SendEntries", reader->Name());
+
+        for ( const auto& e : entries )
+            delete e.idxhash;
+
+        return;
+    }
 
+    if ( i->stream_type != TABLE_STREAM ) {
+        for ( const auto& e : entries ) {
+            delete e.idxhash;
+            SendEntry(reader, e.vals);
+        }
+
+        return;
+    }
+
+    auto* stream = static_cast<TableStream*>(i);
+    double start = util::current_time(true);
+
+    for ( const auto& e : entries ) {
+        int readFields = SendEntryTable(i, e.vals, e.idxhash, e.valhash);
+        Value::delete_value_ptr_array(e.vals, readFields);
+    }
+
+    stream->update_time += util::current_time(true) - start;
+}
+
+int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
     assert(i);
 
     assert(i->stream_type == TABLE_STREAM);
@@ -1085,13 +1141,8 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
 
     zeek::detail::HashKey* idxhash = HashValues(stream->num_idx_fields, vals);
 
-    if ( idxhash == nullptr ) {
-        Warning(i, "Could not hash line. Ignoring");
-        return stream->num_val_fields + stream->num_idx_fields;
-    }
-
     zeek::detail::hash_t valhash = 0;
-    if ( stream->num_val_fields > 0 ) {
+    if ( idxhash && stream->num_val_fields > 0 ) {
         if ( zeek::detail::HashKey* valhashkey = HashValues(stream->num_val_fields, vals + stream->num_idx_fields) ) {
             valhash = valhashkey->Hash();
             delete (valhashkey);
@@ -1102,6 +1153,23 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
         }
     }
 
+    return SendEntryTable(i, vals, idxhash, valhash);
+}
+
+int Manager::SendEntryTable(Stream* i, const Value* const* vals, zeek::detail::HashKey* idxhash,
+                            zeek::detail::hash_t valhash) {
+    bool updated = false;
+
+    assert(i);
+
+    assert(i->stream_type == TABLE_STREAM);
+    TableStream* stream = (TableStream*)i;
+
+    if ( idxhash == nullptr ) {
+        Warning(i, "Could not hash line. Ignoring");
+        return stream->num_val_fields + stream->num_idx_fields;
+    }
+
     InputHash* h = stream->lastDict->Lookup(idxhash);
     if ( h ) {
         // seen before
@@ -1256,12 +1324,12 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
     return stream->num_val_fields + stream->num_idx_fields;
 }
 
-void Manager::EndCurrentSend(ReaderFrontend* reader) {
+bool Manager::EndCurrentSend(ReaderFrontend* reader, double max_time) {
     Stream* i = FindStream(reader);
 
     if ( i == nullptr ) {
         reporter->InternalWarning("Unknown reader %s in EndCurrentSend", reader->Name());
-        return;
+        return true;
     }
 
 #ifdef DEBUG
@@ -1274,14 +1342,24 @@ void Manager::EndCurrentSend(ReaderFrontend* reader) {
 #endif
         // just signal the end of the data source
         SendEndOfData(i);
-        return;
+        return true;
     }
 
     assert(i->stream_type == TABLE_STREAM);
     auto* stream = static_cast<TableStream*>(i);
 
-    // lastdict contains all deleted entries and should be empty apart from that
+    double start = util::current_time(true);
+    double deadline = max_time > 0.0 ? start + max_time : 0.0;
+
+    // lastdict contains all deleted entries and should be empty apart from that.
+    // Each entry leaves it once handled, so a later call picks up where an
+    // interrupted one stopped.
     for ( auto it = stream->lastDict->begin_robust(); it != stream->lastDict->end_robust(); ++it ) {
+        if ( deadline > 0.0 && util::current_time(true) > deadline ) {
+            stream->update_time += util::current_time(true) - start;
+            return false;
+        }
+
         auto lastDictIdxKey = it->GetHashKey();
         InputHash* ih = it->value;
 
@@ -1331,11 +1409,24 @@ void Manager::EndCurrentSend(ReaderFrontend* reader) {
     stream->currDict = new PDict<InputHash>;
     stream->currDict->SetDeleteFunc(input_hash_delete_func);
 
+    double update_time = stream->update_time + (util::current_time(true) - start);
+    stream->update_time = 0.0;
+
+    if ( ! table_update_time_metric )
+        table_update_time_metric =
+            telemetry_mgr->HistogramInstance("zeek", "input_table_update_main_thread", {},
+                                             {0.001, 0.01, 0.1, 1.0, 10.0},
+                                             "Main-thread time spent applying an update of a table stream", "seconds");
+
+    table_update_time_metric->Observe(update_time);
+
 #ifdef DEBUG
-    DBG_LOG(DBG_INPUT, "EndCurrentSend complete for stream %s", i->name.c_str());
+    DBG_LOG(DBG_INPUT, "EndCurrentSend complete for stream %s, main thread spent %.3fs on the update",
+            i->name.c_str(), update_time);
 #endif
 
     SendEndOfData(i);
+    return true;
 }
 
 void Manager::SendEndOfData(ReaderFrontend* reader) {
@@ -1797,7 +1888,7 @@ RecordVal* Manager::ValueToRecordVal(const Stream* stream, const Value* const* v
 
 // Count the length of the values used to create a correct length buffer for
 // hashing later
-int Manager::GetValueLength(const Value* val) const {
+int Manager::GetValueLength(const Value* val) {
     assert(val->present); // presence has to be checked elsewhere
     int length = 0;
 
@@ -1868,7 +1959,7 @@ int Manager::GetValueLength(const Value* val) const {
 
 // Given a threading::value, copy the raw data bytes into *data and return how many bytes were
 // copied. Used for hashing the values for lookup in the Zeek table
-int Manager::CopyValue(char* data, const int startpos, const Value* val) const {
+int Manager::CopyValue(char* data, const int startpos, const Value* val) {
     assert(val->present); // presence has to be checked elsewhere
 
     switch ( val->type ) {
@@ -1979,9 +2070,26 @@ int Manager::CopyValue(char* data, const int startpos, const Value* val) const {
     return 0;
 }
 
+Manager::HashedEntry Manager::HashEntry(Value** vals, int num_fields, int num_key_fields) {
+    HashedEntry e{vals, nullptr, 0};
+
+    if ( num_key_fields > 0 ) {
+        e.idxhash = HashValues(num_key_fields, vals);
+
+        if ( e.idxhash && num_fields > num_key_fields ) {
+            if ( auto* valhashkey = HashValues(num_fields - num_key_fields, vals + num_key_fields) ) {
+                e.valhash = valhashkey->Hash();
+                delete valhashkey;
+            }
+        }
+    }
+
+    return e;
+}
+
 // Hash num_elements threading values and return the HashKey for them. At least one of the vals has
 // to be ->present.
-zeek::detail::HashKey* Manager::HashValues(const int num_elements, const Value* const* vals) const {
+zeek::detail::HashKey* Manager::HashValues(const int num_elements, const Value* const* vals) {
     int length = 0;
 
     for ( int i = 0; i < num_elements; i++ ) {
@@ -5,8 +5,11 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "zeek/EventHandler.h"
+#include "zeek/Hash.h"
 #include "zeek/Tag.h"
 #include "zeek/input/Component.h"
 #include "zeek/plugin/ComponentManager.h"
@@ -16,6 +19,11 @@ namespace zeek {
 
 class RecordVal;
 
+namespace telemetry {
+class Histogram;
+using HistogramPtr = std::shared_ptr<Histogram>;
+} // namespace telemetry
+
 namespace input {
 
 class ReaderFrontend;
@@ -121,6 +129,7 @@ protected:
     friend class DeleteMessage;
     friend class ClearMessage;
     friend class SendEntryMessage;
+    friend class SendEntriesMessage;
     friend class EndCurrentSendMessage;
     friend class ReaderClosedMessage;
     friend class DisableMessage;
@@ -141,7 +150,28 @@ protected:
     // monitoring new/deleted values) Functions take ownership of
     // threading::Value fields.
     void SendEntry(ReaderFrontend* reader, threading::Value** vals);
-    void EndCurrentSend(ReaderFrontend* reader);
+
+    // Removes the entries of a table stream that the last update didn't
+    // contain. With max_time set, returns false once that much time has
+    // passed and leaves the remaining entries for the next call, which
+    // continues the work.
+    bool EndCurrentSend(ReaderFrontend* reader, double max_time = 0.0);
+
+    // An entry sent as part of a batch. For table streams, the reader
+    // thread has already computed the entry's hashes.
+    struct HashedEntry {
+        threading::Value** vals;
+        zeek::detail::HashKey* idxhash; // Null if not a table entry or if hashing failed.
+        zeek::detail::hash_t valhash;
+    };
+
+    // Like SendEntry(), for an entry with its hashes. Takes ownership of
+    // the entry's values and hashes.
+    void SendEntry(ReaderFrontend* reader, const HashedEntry& entry);
+
+    // Like SendEntry(), for a batch of entries. Takes ownership of the
+    // entries' values and hashes.
+    void SendEntries(ReaderFrontend* reader, const std::vector<HashedEntry>& entries);
 
     // Instantiates a new ReaderBackend of the given type (note that
     // doing so creates a new thread!).
@@ -191,6 +221,8 @@ private:
 
     // SendEntry implementation for Table stream.
     int SendEntryTable(Stream* i, const threading::Value* const* vals);
+    int SendEntryTable(Stream* i, const threading::Value* const* vals, zeek::detail::HashKey* idxhash,
+                       zeek::detail::hash_t valhash);
 
     // Put implementation for Table stream.
     int PutTable(Stream* i, const threading::Value* const* vals);
@@ -214,15 +246,20 @@ private:
     // Call predicate function and return result.
     bool CallPred(Func* pred_func, const int numvals, ...) const;
 
-    // Get a hashkey for a set of threading::Values.
-    zeek::detail::HashKey* HashValues(const int num_elements, const threading::Value* const* vals) const;
+    // Get a hashkey for a set of threading::Values. Safe to call from
+    // reader threads.
+    static zeek::detail::HashKey* HashValues(const int num_elements, const threading::Value* const* vals);
+
+    // Computes the hashes of a table entry whose first num_key_fields
+    // values form the index. Safe to call from reader threads.
+    static HashedEntry HashEntry(threading::Value** vals, int num_fields, int num_key_fields);
 
     // Get the memory used by a specific value.
-    int GetValueLength(const threading::Value* val) const;
+    static int GetValueLength(const threading::Value* val);
 
     // Copies the raw data in a specific threading::Value to position
     // startpos.
-    int CopyValue(char* data, const int startpos, const threading::Value* val) const;
+    static int CopyValue(char* data, const int startpos, const threading::Value* val);
 
     // Convert Threading::Value to an internal Zeek Type (works with Records).
     Val* ValueToVal(const Stream* i, const threading::Value* val, Type* request_type, bool& have_error) const;
@@ -261,6 +298,9 @@ private:
     std::map<ReaderFrontend*, Stream*> readers;
 
     EventHandlerPtr end_of_data;
+
+    // Main-thread time spent per table stream update, created on first use.
+    telemetry::HistogramPtr table_update_time_metric;
 };
 
 } // namespace input
@@ -5,6 +5,7 @@
 #include "zeek/Desc.h"
 #include "zeek/input/Manager.h"
 #include "zeek/input/ReaderFrontend.h"
+#include "zeek/input/input.bif.h"
 
 using zeek::threading::Field;
 using zeek::threading::Value;
@@ -69,16 +70,38 @@ private:
 
 class SendEntryMessage final : public threading::OutputMessage<ReaderFrontend> {
 public:
-    SendEntryMessage(ReaderFrontend* reader, Value** val)
-        : threading::OutputMessage<ReaderFrontend>("SendEntry", reader), val(val) {}
+    // Runs on the reader's thread, and so hashes table entries there.
+    SendEntryMessage(ReaderFrontend* reader, Value** val, int num_fields, int num_key_fields)
+        : threading::OutputMessage<ReaderFrontend>("SendEntry", reader),
+          entry(Manager::HashEntry(val, num_fields, num_key_fields)) {}
 
     bool Process() override {
-        input_mgr->SendEntry(Object(), val);
+        input_mgr->SendEntry(Object(), entry);
         return true;
     }
 
 private:
-    Value** val;
+    Manager::HashedEntry entry;
+};
+
+class SendEntriesMessage final : public threading::OutputMessage<ReaderFrontend> {
+public:
+    // Runs on the reader's thread, and so hashes table entries there.
+    SendEntriesMessage(ReaderFrontend* reader, const std::vector<Value**>& vals, int num_fields, int num_key_fields)
+        : threading::OutputMessage<ReaderFrontend>("SendEntries", reader) {
+        entries.reserve(vals.size());
+
+        for ( auto* val : vals )
+            entries.push_back(Manager::HashEntry(val, num_fields, num_key_fields));
+    }
+
+    bool Process() override {
+        input_mgr->SendEntries(Object(), entries);
+        return true;
+    }
+
+private:
+    std::vector<Manager::HashedEntry> entries;
 };
 
 class EndCurrentSendMessage final : public threading::OutputMessage<ReaderFrontend> {
@@ -87,11 +110,14 @@ public:
         : threading::OutputMessage<ReaderFrontend>("EndCurrentSend", reader) {}
 
     bool Process() override {
-        input_mgr->EndCurrentSend(Object());
+        pending = ! input_mgr->EndCurrentSend(Object(), BifConst::Input::update_slice);
         return true;
     }
 
+    bool Pending() const override { return pending; }
+
 private:
+    bool pending = false;
 };
 
 class EndOfDataMessage final : public threading::OutputMessage<ReaderFrontend> {
@@ -170,9 +196,16 @@ void ReaderBackend::EndCurrentSend() { SendOut(new EndCurrentSendMessage(fronten
 
 void ReaderBackend::EndOfData() { SendOut(new EndOfDataMessage(frontend)); }
 
-void ReaderBackend::SendEntry(Value** vals) { SendOut(new SendEntryMessage(frontend, vals)); }
+void ReaderBackend::SendEntry(Value** vals) {
+    SendOut(new SendEntryMessage(frontend, vals, num_fields, num_key_fields));
+}
+
+void ReaderBackend::SendEntries(std::vector<Value**> vals) {
+    if ( ! vals.empty() )
+        SendOut(new SendEntriesMessage(frontend, vals, num_fields, num_key_fields));
+}
 
-bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const* arg_fields) {
+bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const* arg_fields, int arg_num_key_fields) {
     if ( Failed() )
         return true;
 
@@ -181,6 +214,7 @@ bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const
     SetOSName(Fmt("zk.%s", Name()));
 
     num_fields = arg_num_fields;
+    num_key_fields = arg_num_key_fields;
     fields = arg_fields;
 
     // disable if DoInit returns error.
@@ -238,6 +272,8 @@ void ReaderBackend::DisableFrontend() {
     SendOut(new DisableMessage(frontend));
 }
 
+double ReaderBackend::MaxProcessTime() const { return BifConst::Input::update_slice; }
+
 bool ReaderBackend::OnHeartbeat(double network_time, double current_time) {
     if ( Failed() )
         return true;
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "zeek/ZeekString.h"
 #include "zeek/input/Component.h"
 #include "zeek/threading/MsgThread.h"
@@ -151,9 +153,14 @@ public:
      * @param config A string map containing additional configuration options
      * for the reader.
      *
+     * @param num_key_fields For table streams, the number of leading
+     * fields that make up the table's index. Entries sent with
+     * SendEntry() or SendEntries() then get their hashes computed on the
+     * reader's thread, rather than the main thread.
+     *
      * @return False if an error occurred.
      */
-    bool Init(int num_fields, const threading::Field* const* fields);
+    bool Init(int num_fields, const threading::Field* const* fields, int num_key_fields = 0);
 
     /**
      * Force trigger an update of the input stream. The action that will
@@ -208,6 +215,7 @@ public:
     // Overridden from MsgThread.
     bool OnHeartbeat(double network_time, double current_time) override;
     bool OnFinish(double network_time) override;
+    double MaxProcessTime() const override;
 
     void Info(const char* msg) override;
 
@@ -335,13 +343,24 @@ protected:
      * specific stream back to the manager in tracking mode.
      *
      * If the stream is a table stream, the values are inserted into the
-     * table; if it is an event stream, the event is raised.
+     * table; if it is an event stream, the event is raised. For table
+     * streams, this computes the entry's hashes right away on the calling
+     * thread.
      *
      * @param val Array of threading::Values expected by the stream. The
      * array must have exactly NumEntries() elements.
      */
     void SendEntry(threading::Value** vals);
 
+    /**
+     * Like SendEntry(), but passes a whole batch of entries to the
+     * manager with a single message. The entries are processed in the
+     * order given.
+     *
+     * @param vals The entries, each as described for SendEntry().
+     */
+    void SendEntries(std::vector<threading::Value**> vals);
+
     /**
      * Method telling the manager, that the current list of entries sent
      * by SendEntry is finished.
@@ -359,6 +378,7 @@ private:
 
     ReaderInfo* info;
     unsigned int num_fields;
+    unsigned int num_key_fields = 0;
     const threading::Field* const* fields; // raw mapping
 
     bool disabled;
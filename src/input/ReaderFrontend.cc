@@ -9,14 +9,19 @@ namespace zeek::input {
 
 class InitMessage final : public threading::InputMessage<ReaderBackend> {
 public:
-    InitMessage(ReaderBackend* backend, const int num_fields, const threading::Field* const* fields)
-        : threading::InputMessage<ReaderBackend>("Init", backend), num_fields(num_fields), fields(fields) {}
+    InitMessage(ReaderBackend* backend, const int num_fields, const threading::Field* const* fields,
+                int num_key_fields)
+        : threading::InputMessage<ReaderBackend>("Init", backend),
+          num_fields(num_fields),
+          fields(fields),
+          num_key_fields(num_key_fields) {}
 
-    bool Process() override { return Object()->Init(num_fields, fields); }
+    bool Process() override { return Object()->Init(num_fields, fields, num_key_fields); }
 
 private:
     const int num_fields;
     const threading::Field* const* fields;
+    const int num_key_fields;
 };
 
 class UpdateMessage final : public threading::InputMessage<ReaderBackend> {
@@ -50,7 +55,7 @@ ReaderFrontend::~ReaderFrontend() {
     delete info;
 }
 
-void ReaderFrontend::Init(const int arg_num_fields, const threading::Field* const* arg_fields) {
+void ReaderFrontend::Init(const int arg_num_fields, const threading::Field* const* arg_fields, int num_key_fields) {
     if ( disabled )
         return;
 
@@ -61,7 +66,7 @@ void ReaderFrontend::Init(const int arg_num_fields, const threading::Field* cons
     fields = arg_fields;
     initialized = true;
 
-    backend->SendIn(new InitMessage(backend, num_fields, fields));
+    backend->SendIn(new InitMessage(backend, num_fields, fields, num_key_fields));
 }
 
 void ReaderFrontend::Update() {
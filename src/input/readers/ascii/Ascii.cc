@@ -2,10 +2,17 @@
 
 #include "zeek/input/readers/ascii/Ascii.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <thread>
+#include <utility>
 
 #include "zeek/input/readers/ascii/ascii.bif.h"
 #include "zeek/threading/SerialTypes.h"
@@ -16,6 +23,76 @@ using zeek::threading::Value;
 
 namespace zeek::input::reader::detail {
 
+// Chunks of a file smaller than this aren't worth a thread of their own.
+static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+// Maximum number of entries sent to the manager with a single message.
+static const size_t MAX_BATCH_SIZE = 1024;
+
+// The outcome of parsing a line on a helper thread.
+struct ParsedLine {
+    int line;             // Line number, relative to the start of its chunk.
+    Value** vals;         // The values to send, or null if there's a problem.
+    std::string msg;      // The problem to report, if any.
+    bool invalid = false; // True if msg reports an invalid line.
+};
+
+// A range of lines parsed by one thread.
+struct Ascii::Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    int lines = 0; // Number of lines parsed so far.
+    std::vector<ParsedLine> parsed;
+};
+
+// The chunk the current thread is parsing. While set, warnings are recorded
+// with the chunk for later rather than reported right away.
+static thread_local void* current_chunk = nullptr;
+
+// A read-only memory mapping of a file.
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if ( fd < 0 )
+            return;
+
+        struct stat sb;
+        if ( fstat(fd, &sb) == 0 && sb.st_size > 0 ) {
+            void* p = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if ( p != MAP_FAILED ) {
+                data = static_cast<const char*>(p);
+                size = sb.st_size;
+            }
+        }
+
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if ( data )
+            munmap(const_cast<char*>(data), size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+static void delete_values(Value** vals, int num) {
+    for ( int i = 0; i < num; i++ )
+        delete vals[i];
+
+    delete[] vals;
+}
+
+static void set_line_number(Value** vals, int num, int line) {
+    for ( int i = 0; i < num; i++ )
+        vals[i]->SetFileLineNumber(line);
+}
+
 FieldMapping::FieldMapping(const string& arg_name, const TypeTag& arg_type, int arg_position)
     : name(arg_name), type(arg_type), subtype(TYPE_ERROR) {
     position = arg_position;
@@ -58,6 +135,7 @@ Ascii::Ascii(ReaderFrontend* frontend) : ReaderBackend(frontend) {
     ino = 0;
     fail_on_file_problem = false;
     fail_on_invalid_lines = false;
+    parse_threads = 0;
 }
 
 void Ascii::DoClose() { read_location.reset(); }
@@ -82,6 +160,8 @@ bool Ascii::DoInit(const ReaderInfo& info, int num_fields, const Field* const* f
     path_prefix.assign((const char*)BifConst::InputAscii::path_prefix->Bytes(),
                        BifConst::InputAscii::path_prefix->Len());
 
+    parse_threads = BifConst::InputAscii::parse_threads;
+
     // Set per-filter configuration options.
     for ( const auto& [k, v] : info.config ) {
         if ( strcmp(k, "separator") == 0 )
@@ -101,6 +181,9 @@ bool Ascii::DoInit(const ReaderInfo& info, int num_fields, const Field* const* f
 
         else if ( strcmp(k, "fail_on_file_problem") == 0 )
             fail_on_file_problem = (strncmp(v, "T", 1) == 0);
+
+        else if ( strcmp(k, "parse_threads") == 0 )
+            parse_threads = std::max(atoi(v), 0);
     }
 
     if ( separator.size() != 1 )
@@ -313,105 +396,276 @@ bool Ascii::DoUpdate() {
         default: assert(false);
     }
 
+    if ( parse_threads > 1 && Info().mode != MODE_STREAM ) {
+        // Parse the remainder of the file in parallel if we can map it
+        // into memory. Otherwise, fall back to reading it line by line.
+        MappedFile mapped(fname);
+
+        if ( mapped.data ) {
+            std::streamoff data_start = file.tellg();
+
+            if ( data_start < 0 || static_cast<size_t>(data_start) > mapped.size )
+                data_start = mapped.size;
+
+            return ParseMapped(mapped.data + data_start, mapped.data + mapped.size);
+        }
+    }
+
     string line;
 
     file.sync();
 
     while ( GetLine(line) ) {
-        // split on tabs
-        bool error = false;
-        auto stringfields = util::split(line, separator[0]);
-
-        // This needs to be a signed value or the comparisons below will fail.
-        int pos = static_cast<int>(stringfields.size() - 1);
-
-        Value** fields = new Value*[NumFields()];
-
-        int fpos = 0;
-        for ( const auto& fit : columnMap ) {
-            if ( ! fit.present ) {
-                // add non-present field
-                fields[fpos] = new Value(fit.type, false);
-                if ( read_location )
-                    fields[fpos]->SetFileLineNumber(read_location->first_line);
-                fpos++;
-                continue;
+        string invalid;
+        Value** fields = ParseLine(line, formatter.get(), &invalid);
+
+        if ( ! fields ) {
+            // Encountered an invalid line. Unless that's fatal, ignore it.
+            if ( ! invalid.empty() ) {
+                FailWarn(fail_on_invalid_lines, invalid.c_str(), ! fail_on_invalid_lines);
+
+                if ( fail_on_invalid_lines )
+                    return false;
             }
 
-            assert(fit.position >= 0);
+            continue;
+        }
 
-            if ( fit.position > pos || fit.secondary_position > pos ) {
-                FailWarn(fail_on_invalid_lines,
-                         Fmt("Not enough fields in line '%s' of %s. Found "
-                             "%d fields, want positions %d and %d",
-                             line.c_str(), fname.c_str(), pos, fit.position, fit.secondary_position),
-                         ! fail_on_invalid_lines);
+        // If there's no error, then it makes sense to report the next error.
+        StopWarningSuppression();
 
-                if ( fail_on_invalid_lines ) {
-                    for ( int i = 0; i < fpos; i++ )
-                        delete fields[i];
+        if ( read_location )
+            set_line_number(fields, NumFields(), read_location->first_line);
 
-                    delete[] fields;
+        if ( Info().mode == MODE_STREAM )
+            Put(fields);
+        else
+            SendEntry(fields);
+    }
 
-                    return false;
-                }
-                else {
-                    error = true;
-                    break;
-                }
-            }
+    if ( Info().mode != MODE_STREAM )
+        EndCurrentSend();
 
-            Value* val = formatter->ParseValue(stringfields[fit.position], fit.name, fit.type, fit.subtype);
-            if ( ! val ) {
-                Warning(Fmt("Could not convert line '%s' of %s to Val. Ignoring line.", line.c_str(), fname.c_str()));
-                error = true;
-                break;
-            }
+    StopWarningSuppression();
+    return true;
+}
 
-            if ( read_location )
-                val->SetFileLineNumber(read_location->first_line);
+Value** Ascii::ParseLine(const string& line, threading::Formatter* fmt, string* invalid) {
+    // split on tabs
+    auto stringfields = util::split(line, separator[0]);
 
-            if ( fit.secondary_position != -1 ) {
-                // we have a port definition :)
-                assert(val->type == TYPE_PORT);
-                val->val.port_val.proto = formatter->ParseProto(stringfields[fit.secondary_position]);
-            }
+    // This needs to be a signed value or the comparisons below will fail.
+    int pos = static_cast<int>(stringfields.size() - 1);
 
-            fields[fpos] = val;
+    Value** fields = new Value*[NumFields()];
 
+    int fpos = 0;
+    for ( const auto& fit : columnMap ) {
+        if ( ! fit.present ) {
+            // add non-present field
+            fields[fpos] = new Value(fit.type, false);
             fpos++;
+            continue;
+        }
+
+        assert(fit.position >= 0);
+
+        if ( fit.position > pos || fit.secondary_position > pos ) {
+            *invalid = Fmt(
+                "Not enough fields in line '%s' of %s. Found "
+                "%d fields, want positions %d and %d",
+                line.c_str(), fname.c_str(), pos, fit.position, fit.secondary_position);
+
+            delete_values(fields, fpos);
+            return nullptr;
         }
 
-        if ( error ) {
-            // Encountered non-fatal error, ignoring line. But
-            // first, delete all successfully read fields and the
-            // array structure.
+        Value* val = fmt->ParseValue(stringfields[fit.position], fit.name, fit.type, fit.subtype);
+        if ( ! val ) {
+            Warning(Fmt("Could not convert line '%s' of %s to Val. Ignoring line.", line.c_str(), fname.c_str()));
+            delete_values(fields, fpos);
+            return nullptr;
+        }
+
+        if ( fit.secondary_position != -1 ) {
+            // we have a port definition :)
+            assert(val->type == TYPE_PORT);
+            val->val.port_val.proto = fmt->ParseProto(stringfields[fit.secondary_position]);
+        }
+
+        fields[fpos] = val;
+
+        fpos++;
+    }
+
+    assert(fpos == NumFields());
+    return fields;
+}
+
+void Ascii::ParseChunk(Chunk* chunk, threading::Formatter* fmt) {
+    current_chunk = chunk;
+
+    string line;
+    const char* p = chunk->begin;
+
+    while ( p < chunk->end ) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', chunk->end - p));
+        if ( ! eol )
+            eol = chunk->end;
 
-            for ( int i = 0; i < fpos; i++ )
-                delete fields[i];
+        line.assign(p, eol - p);
+        p = eol < chunk->end ? eol + 1 : chunk->end;
+        chunk->lines++;
 
-            delete[] fields;
+        // Skip the same lines that GetLine() does.
+        if ( line.empty() )
             continue;
+
+        if ( line.back() == '\r' ) // deal with \r\n by removing \r
+            line.pop_back();
+
+        if ( line[0] == '#' ) {
+            if ( (line.length() > 8) && (line.compare(0, 7, "#fields") == 0) && (line[7] == separator[0]) )
+                line.erase(0, 8);
+            else
+                continue;
         }
-        // If there's no error, then it makes sense to report the next error.
-        else
-            StopWarningSuppression();
 
-        assert(fpos == NumFields());
+        string invalid;
+        Value** vals = ParseLine(line, fmt, &invalid);
 
-        if ( Info().mode == MODE_STREAM )
-            Put(fields);
+        if ( vals || ! invalid.empty() ) {
+            chunk->parsed.push_back({chunk->lines, vals, std::move(invalid), vals == nullptr});
+
+            // No use parsing further if the line stops the reader.
+            if ( ! vals && fail_on_invalid_lines )
+                break;
+        }
+    }
+
+    current_chunk = nullptr;
+}
+
+bool Ascii::ParseMapped(const char* begin, const char* end) {
+#ifdef DEBUG
+    double start_time = util::current_time();
+#endif
+
+    size_t len = end - begin;
+    size_t num_chunks = std::clamp<size_t>(len / MIN_CHUNK_SIZE, 1, parse_threads);
+
+    // Split the data into chunks of about the same size, ending on line
+    // boundaries.
+    std::vector<Chunk> chunks(num_chunks);
+    const char* p = begin;
+
+    for ( size_t i = 0; i < num_chunks; i++ ) {
+        chunks[i].begin = p;
+
+        if ( i < num_chunks - 1 ) {
+            const char* target = std::max(p, begin + len * (i + 1) / num_chunks);
+            const char* eol = static_cast<const char*>(memchr(target, '\n', end - target));
+            p = eol ? eol + 1 : end;
+        }
         else
-            SendEntry(fields);
+            p = end;
+
+        chunks[i].end = p;
     }
 
-    if ( Info().mode != MODE_STREAM )
-        EndCurrentSend();
+    // Parse the first chunk ourselves, and the others on helper threads
+    // with their own formatters.
+    threading::formatter::Ascii::SeparatorInfo sep_info(separator, set_separator, unset_field, empty_field);
+    std::vector<std::thread> helpers;
+
+    for ( size_t i = 1; i < num_chunks; i++ )
+        helpers.emplace_back([this, chunk = &chunks[i], sep_info]() {
+            BlockSignals();
+            threading::formatter::Ascii fmt(this, sep_info);
+            ParseChunk(chunk, &fmt);
+        });
+
+    ParseChunk(&chunks[0], formatter.get());
 
+    for ( auto& t : helpers )
+        t.join();
+
+    // Now pass everything on in file order, with problems reported just
+    // like when reading line by line.
+    int line_offset = read_location ? read_location->first_line : 0;
+    [[maybe_unused]] uint64_t num_entries = 0;
+    bool failed = false;
+    std::vector<Value**> batch;
+
+    for ( auto& chunk : chunks ) {
+        for ( auto& pl : chunk.parsed ) {
+            if ( failed ) {
+                if ( pl.vals )
+                    delete_values(pl.vals, NumFields());
+
+                continue;
+            }
+
+            int line = line_offset + pl.line;
+
+            if ( read_location ) {
+                read_location->first_line = line;
+                read_location->last_line = line;
+            }
+
+            if ( pl.vals ) {
+                StopWarningSuppression();
+
+                set_line_number(pl.vals, NumFields(), line);
+                batch.push_back(pl.vals);
+                num_entries++;
+
+                if ( batch.size() == MAX_BATCH_SIZE )
+                    SendEntries(std::exchange(batch, {}));
+
+                continue;
+            }
+
+            // Keep problems in order with the entries preceding them.
+            SendEntries(std::exchange(batch, {}));
+
+            if ( pl.invalid ) {
+                FailWarn(fail_on_invalid_lines, pl.msg.c_str(), ! fail_on_invalid_lines);
+                failed = fail_on_invalid_lines;
+            }
+            else
+                Warning(pl.msg.c_str());
+        }
+
+        line_offset += chunk.lines;
+    }
+
+    if ( failed )
+        return false;
+
+    SendEntries(std::move(batch));
+    EndCurrentSend();
     StopWarningSuppression();
+
+#ifdef DEBUG
+    double elapsed = util::current_time() - start_time;
+    Debug(DBG_INPUT, Fmt("%s: parsed %" PRIu64 " entries with %zu threads in %.3fs (%.0f entries/sec)", fname.c_str(),
+                         num_entries, num_chunks, elapsed, elapsed > 0 ? num_entries / elapsed : 0.0));
+#endif
+
     return true;
 }
 
+void Ascii::Warning(const char* msg) {
+    if ( current_chunk ) {
+        auto* chunk = static_cast<Chunk*>(current_chunk);
+        chunk->parsed.push_back({chunk->lines, nullptr, msg});
+        return;
+    }
+
+    ReaderBackend::Warning(msg);
+}
+
 bool Ascii::DoHeartbeat(double network_time, double current_time) {
     if ( ! OpenFile() )
         return ! fail_on_file_problem;
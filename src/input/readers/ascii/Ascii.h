@@ -6,6 +6,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "zeek/Obj.h"
@@ -50,6 +51,8 @@ public:
 
     static ReaderBackend* Instantiate(ReaderFrontend* frontend) { return new Ascii(frontend); }
 
+    void Warning(const char* msg) override;
+
 protected:
     bool DoInit(const ReaderInfo& info, int arg_num_fields, const threading::Field* const* fields) override;
     void DoClose() override;
@@ -59,10 +62,26 @@ protected:
     const zeek::detail::Location* GetLocationInfo() const override { return read_location.get(); }
 
 private:
+    struct Chunk;
+
     bool ReadHeader(bool useCached);
     bool GetLine(std::string& str);
     bool OpenFile();
 
+    // Converts a data line into the values to send to the manager.
+    // Returns null if the line cannot be converted; if that's because
+    // the line is invalid, sets *invalid to the reason.
+    threading::Value** ParseLine(const std::string& line, threading::Formatter* fmt, std::string* invalid);
+
+    // Parses a chunk of lines, recording the outcome for each line.
+    // Runs on helper threads, see ParseMapped().
+    void ParseChunk(Chunk* chunk, threading::Formatter* fmt);
+
+    // Parses the data lines of a file mapped into memory, splitting the
+    // work across up to parse_threads threads. The entries are sent to
+    // the manager in file order.
+    bool ParseMapped(const char* begin, const char* end);
+
     std::ifstream file;
     time_t mtime;
     ino_t ino;
@@ -86,6 +105,7 @@ private:
     bool fail_on_invalid_lines;
     bool fail_on_file_problem;
     std::string path_prefix;
+    unsigned int parse_threads;
 
     std::unique_ptr<threading::Formatter> formatter;
 
@@ -44,6 +44,9 @@ void SQLite::DoClose() {
     sqlite3_finalize(st);
     st = nullptr;
 
+    sqlite3_value_free(last_value);
+    last_value = nullptr;
+
     if ( db != 0 ) {
         sqlite3_close(db);
         db = 0;
@@ -73,7 +76,16 @@ bool SQLite::DoInit(const ReaderInfo& info, int arg_num_fields, const threading:
     sqlite3_enable_shared_cache(1);
 #endif
 
-    if ( Info().mode != MODE_MANUAL ) {
+    ReaderInfo::config_map::const_iterator it = info.config.find("incremental_column");
+    if ( it != info.config.end() )
+        incremental_column = it->second;
+
+    if ( Info().mode == MODE_STREAM && incremental_column.empty() ) {
+        Error("SQLite only supports stream mode with incremental_column set.");
+        return false;
+    }
+
+    if ( Info().mode != MODE_MANUAL && Info().mode != MODE_STREAM ) {
         Error("SQLite only supports manual reading mode.");
         return false;
     }
@@ -84,7 +96,7 @@ bool SQLite::DoInit(const ReaderInfo& info, int arg_num_fields, const threading:
     fullpath.append(".sqlite");
 
     std::string query;
-    ReaderInfo::config_map::const_iterator it = info.config.find("query");
+    it = info.config.find("query");
     if ( it == info.config.end() ) {
         Error(Fmt("No query specified when setting up SQLite data source %s. Aborting.", info.source));
         return false;
@@ -98,6 +110,21 @@ bool SQLite::DoInit(const ReaderInfo& info, int arg_num_fields, const threading:
     num_fields = arg_num_fields;
     fields = arg_fields;
 
+    if ( ! incremental_column.empty() ) {
+        // Only fetch rows past the largest value of the column seen so far.
+        auto end = query.find_last_not_of("; \t\r\n");
+        query.erase(end == std::string::npos ? 0 : end + 1);
+
+        char* column = sqlite3_mprintf("\"%w\"", incremental_column.c_str());
+        if ( ! column ) {
+            InternalError("Could not malloc memory");
+            return false;
+        }
+
+        query = "SELECT * FROM (" + query + ") WHERE ?1 IS NULL OR " + column + " > ?1 ORDER BY " + column;
+        sqlite3_free(column);
+    }
+
     // create the prepared select statement that we will re-use forever...
     if ( checkError(sqlite3_prepare_v2(db, query.c_str(), query.size() + 1, &st, NULL)) ) {
         return false;
@@ -265,6 +292,28 @@ bool SQLite::DoUpdate() {
         }
     }
 
+    int incremental_pos = -1;
+
+    if ( ! incremental_column.empty() ) {
+        for ( int i = 0; i < numcolumns; ++i ) {
+            if ( incremental_column == sqlite3_column_name(st, i) )
+                incremental_pos = i;
+        }
+
+        if ( incremental_pos == -1 ) {
+            Error(Fmt("Incremental column %s not found after SQLite statement", incremental_column.c_str()));
+            delete[] mapping;
+            delete[] submapping;
+            return false;
+        }
+
+        if ( checkError(last_value ? sqlite3_bind_value(st, 1, last_value) : sqlite3_bind_null(st, 1)) ) {
+            delete[] mapping;
+            delete[] submapping;
+            return false;
+        }
+    }
+
     int errorcode;
     while ( (errorcode = sqlite3_step(st)) == SQLITE_ROW ) {
         Value** ofields = new Value*[num_fields];
@@ -282,7 +331,16 @@ bool SQLite::DoUpdate() {
             }
         }
 
-        SendEntry(ofields);
+        if ( incremental_pos != -1 ) {
+            // Rows come ordered by the column, so this one has the largest value yet.
+            sqlite3_value_free(last_value);
+            last_value = sqlite3_value_dup(sqlite3_column_value(st, incremental_pos));
+
+            // Earlier rows remain in place, so just add the new ones.
+            Put(ofields);
+        }
+        else
+            SendEntry(ofields);
     }
 
     delete[] mapping;
@@ -291,7 +349,10 @@ bool SQLite::DoUpdate() {
     if ( checkError(errorcode) ) // check the last error code returned by sqlite
         return false;
 
-    EndCurrentSend();
+    if ( incremental_pos == -1 )
+        EndCurrentSend();
+    else if ( Info().mode == MODE_MANUAL )
+        EndOfData();
 
     if ( checkError(sqlite3_reset(st)) )
         return false;
@@ -299,4 +360,13 @@ bool SQLite::DoUpdate() {
     return true;
 }
 
+bool SQLite::DoHeartbeat(double network_time, double current_time) {
+    // In stream mode, poll for new rows.
+    if ( Info().mode == MODE_STREAM )
+        Update(); // Call Update, not DoUpdate, because Update
+                  // checks the "disabled" flag.
+
+    return true;
+}
+
 } // namespace zeek::input::reader::detail
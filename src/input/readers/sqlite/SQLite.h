@@ -24,7 +24,7 @@ protected:
     bool DoInit(const ReaderInfo& info, int arg_num_fields, const threading::Field* const* arg_fields) override;
     void DoClose() override;
     bool DoUpdate() override;
-    bool DoHeartbeat(double network_time, double current_time) override { return true; }
+    bool DoHeartbeat(double network_time, double current_time) override;
 
 private:
     bool checkError(int code);
@@ -40,6 +40,11 @@ private:
     sqlite3_stmt* st;
     threading::formatter::Ascii* io;
 
+    // For incremental mode, the column to track, and its largest value
+    // seen so far.
+    std::string incremental_column;
+    sqlite3_value* last_value = nullptr;
+
     std::string set_separator;
     std::string unset_field;
     std::string empty_field;
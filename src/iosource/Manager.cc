@@ -288,6 +288,32 @@ bool Manager::RegisterFd(int fd, IOSource* src, int flags) {
     return true;
 }
 
+void Manager::RecreateEventQueue() {
+    int new_queue = kqueue();
+    if ( new_queue == -1 )
+        reporter->FatalError("Failed to initialize kqueue: %s", strerror(errno));
+
+    std::vector<struct kevent> new_events;
+
+    for ( const auto& [fd, src] : fd_map ) {
+        new_events.push_back({});
+        EV_SET(&(new_events.back()), fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+    }
+
+    for ( const auto& [fd, src] : write_fd_map ) {
+        new_events.push_back({});
+        EV_SET(&(new_events.back()), fd, EVFILT_WRITE, EV_ADD, 0, 0, NULL);
+    }
+
+    if ( ! new_events.empty() && kevent(new_queue, new_events.data(), new_events.size(), NULL, 0, NULL) == -1 )
+        reporter->FatalError("Failed to register file descriptors with new kqueue: %s", strerror(errno));
+
+    if ( event_queue != -1 )
+        close(event_queue);
+
+    event_queue = new_queue;
+}
+
 bool Manager::UnregisterFd(int fd, IOSource* src, int flags) {
     std::vector<struct kevent> new_events;
 
@@ -142,6 +142,14 @@ public:
      */
     void Wakeup(std::string_view where);
 
+    /**
+     * Replaces the kqueue with a new one that has all currently registered
+     * file descriptors added. A process forked from another one must call
+     * this before using the manager, since a kqueue inherited through
+     * fork() may be shared with the parent.
+     */
+    void RecreateEventQueue();
+
 private:
     /**
      * Internal data structure for managing registered IOSources.
@@ -3,6 +3,7 @@
 #include "zeek/logging/Manager.h"
 
 #include <broker/endpoint_info.hh>
+#include <algorithm>
 #include <functional>
 #include <optional>
 #include <utility>
@@ -20,6 +21,8 @@
 #include "zeek/Type.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/input.h"
+#include "zeek/logging/Predicate.h"
+#include "zeek/logging/RotationPostProcessor.h"
 #include "zeek/logging/WriterBackend.h"
 #include "zeek/logging/WriterFrontend.h"
 #include "zeek/logging/logging.bif.h"
@@ -48,6 +51,7 @@ public:
 
     void Dispatch(double t, bool is_expire) override {
         zeek::log_mgr->FlushAllWriteBuffers();
+        zeek::log_mgr->ReportRotationPostProcessing();
 
         if ( ! is_expire )
             zeek::log_mgr->StartLogFlushTimer();
@@ -215,6 +219,8 @@ struct Manager::Filter {
     bool remote = false;
     double interval = 0.0;
     Func* postprocessor = nullptr;
+    std::unique_ptr<detail::Predicate> predicate;
+    std::shared_ptr<telemetry::Counter> predicate_drops;
 
     int num_fields = 0;
     threading::Field** fields = nullptr;
@@ -483,11 +489,17 @@ Manager::Manager()
           telemetry_mgr
               ->CounterFamily("zeek", "log-writer-writes", {"writer", "module", "stream", "filter-name", "path"},
                               "Total number of log writes passed to a concrete log writer not vetoed by stream or "
-                              "filter policies.")) {
+                              "filter policies.")),
+      total_log_filter_predicate_drops_family(
+          telemetry_mgr->CounterFamily("zeek", "log-filter-predicate-drops", {"module", "stream", "filter-name"},
+                                       "Total number of log records dropped by a filter's predicate.")) {
     rotations_pending = 0;
 }
 
 Manager::~Manager() {
+    // Finishes any outstanding post-processing first.
+    rotation_postprocessor.reset();
+
     for ( vector<Stream*>::iterator s = streams.begin(); s != streams.end(); ++s )
         delete *s;
 }
@@ -875,6 +887,7 @@ bool Manager::AddFilter(EnumVal* id, RecordVal* fval) {
     auto scope_sep = fval->GetFieldOrDefault("scope_sep");
     auto ext_prefix = fval->GetFieldOrDefault("ext_prefix");
     auto ext_func = fval->GetFieldOrDefault("ext_func");
+    auto predicate = fval->GetField("predicate");
 
     Filter* filter = new Filter;
     filter->fval = fval->Ref();
@@ -915,6 +928,17 @@ bool Manager::AddFilter(EnumVal* id, RecordVal* fval) {
         }
     }
 
+    if ( predicate ) {
+        std::string error;
+        filter->predicate = detail::Predicate::Compile(predicate->AsString()->CheckString(), stream->columns, &error);
+
+        if ( ! filter->predicate ) {
+            reporter->Error("invalid predicate for filter '%s': %s", filter->name.c_str(), error.c_str());
+            delete filter;
+            return false;
+        }
+    }
+
     filter->num_fields = 0;
     filter->fields = nullptr;
     if ( ! TraverseRecord(stream, filter, stream->columns, include ? include->AsTableVal() : nullptr,
@@ -953,6 +977,7 @@ bool Manager::AddFilter(EnumVal* id, RecordVal* fval) {
     DBG_LOG(DBG_LOGGING, "   path      : %s", filter->path.c_str());
     DBG_LOG(DBG_LOGGING, "   path_func : %s", (filter->path_func ? "set" : "not set"));
     DBG_LOG(DBG_LOGGING, "   policy    : %s", (filter->policy ? "set" : "not set"));
+    DBG_LOG(DBG_LOGGING, "   predicate : %s", (filter->predicate ? filter->predicate->Expr().c_str() : "not set"));
 
     for ( int i = 0; i < filter->num_fields; i++ ) {
         threading::Field* field = filter->fields[i];
@@ -986,6 +1011,12 @@ bool Manager::RemoveFilter(EnumVal* id, const string& name) {
     return true;
 }
 
+// Returns false if invoking a policy hook can't have any effect because it
+// has no enabled bodies, and no plugin observes function calls.
+static bool need_policy_invoke(const Func* hook) {
+    return hook->HasEnabledBodies() || plugin_mgr->HavePluginForHook(plugin::HOOK_CALL_FUNCTION);
+}
+
 bool Manager::Write(EnumVal* id, RecordVal* columns_arg) {
     Stream* stream = FindStream(id);
     if ( ! stream )
@@ -1021,7 +1052,7 @@ bool Manager::Write(EnumVal* id, RecordVal* columns_arg) {
         detail::WriteContext active_write{{zeek::NewRef{}, id}, columns, idx};
         detail::ActiveWriteScope active_write_scope{active_writes, active_write};
 
-        if ( log_stream_policy_hook ) {
+        if ( log_stream_policy_hook && need_policy_invoke(log_stream_policy_hook.get()) ) {
             auto v = log_stream_policy_hook->Invoke(columns, IntrusivePtr{NewRef{}, id});
             if ( v && ! v->AsBool() ) {
                 // We record the fact that this hook is vetoing
@@ -1061,12 +1092,23 @@ bool Manager::WriteToFilters(const Manager::Stream* stream, zeek::RecordValPtr c
     for ( auto* filter : stream->filters ) {
         string path = filter->path;
 
+        // The filter's predicate runs ahead of any script code.
+        if ( filter->predicate && ! filter->predicate->Eval(columns.get()) ) {
+            if ( ! filter->predicate_drops ) {
+                std::string module_name = zeek::detail::extract_module_name(stream->name.c_str());
+                std::initializer_list<telemetry::LabelView> labels{{"module", module_name},
+                                                                   {"stream", stream->name},
+                                                                   {"filter-name", filter->name}};
+                filter->predicate_drops = total_log_filter_predicate_drops_family->GetOrAdd(labels);
+            }
+
+            filter->predicate_drops->Inc();
+            continue;
+        }
+
         // Policy hooks may veto the logging or alter the log
-        // record if really necessary. Potential optimization:
-        // don't invoke the hook at all when it has no
-        // handlers/bodies. Doing this skips sampling and
-        // plugin hooks, though, so for now we do invoke.
-        if ( filter->policy ) {
+        // record if really necessary.
+        if ( filter->policy && need_policy_invoke(filter->policy) ) {
             auto v = filter->policy->Invoke(columns, IntrusivePtr{NewRef{}, stream->id},
                                             IntrusivePtr{NewRef{}, filter->fval});
             if ( v && ! v->AsBool() )
@@ -1146,10 +1188,13 @@ bool Manager::WriteToFilters(const Manager::Stream* stream, zeek::RecordValPtr c
 
         assert(writer);
 
-        // Alright, can do the write now.
-        auto rec = RecordToLogRecord(stream, filter, columns.get());
+        // Alright, can do the write now. Strings go into the arena of the
+        // writer's current batch, unless plugins may modify the values and
+        // expect them to own their data.
+        bool have_write_hook = zeek::plugin_mgr->HavePluginForHook(zeek::plugin::HOOK_LOG_WRITE);
+        auto rec = RecordToLogRecord(stream, filter, columns.get(), have_write_hook ? nullptr : writer->Arena());
 
-        if ( zeek::plugin_mgr->HavePluginForHook(zeek::plugin::HOOK_LOG_WRITE) ) {
+        if ( have_write_hook ) {
             // The current HookLogWrite API takes a threading::Value**.
             // Fabricate the pointer array on the fly. Mutation is allowed.
             std::vector<threading::Value*> vals;
@@ -1382,11 +1427,20 @@ bool Manager::SetMaxDelayQueueSize(const EnumValPtr& id, zeek_uint_t queue_size)
     return true;
 }
 
-threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
+// Copies a string for a log value, into the arena if there's one.
+static char* copy_log_string(const char* s, size_t len, detail::StringArena* arena) {
+    if ( arena )
+        return arena->Copy(s, len);
+
+    return util::copy_string(s, len);
+}
+
+threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty, detail::StringArena* arena) {
     if ( ! val )
         return {ty->Tag(), false};
 
     threading::Value lval{ty->Tag()};
+    lval.borrowed = arena != nullptr;
 
     switch ( lval.type ) {
         case TYPE_BOOL:
@@ -1397,14 +1451,14 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
 
             if ( s ) {
                 auto len = strlen(s);
-                lval.val.string_val.data = util::copy_string(s, len);
+                lval.val.string_val.data = copy_log_string(s, len, arena);
                 lval.val.string_val.length = len;
             }
 
             else {
                 auto err_msg = "enum type does not contain value:" + std::to_string(val->AsInt());
                 ty->Error(err_msg.c_str());
-                lval.val.string_val.data = util::copy_string("", 0);
+                lval.val.string_val.data = copy_log_string("", 0, arena);
                 lval.val.string_val.length = 0;
             }
             break;
@@ -1442,8 +1496,14 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
 
         case TYPE_STRING: {
             const String* s = val->AsString()->AsString();
-            char* buf = new char[s->Len()];
-            memcpy(buf, s->Bytes(), s->Len());
+            char* buf;
+
+            if ( arena )
+                buf = arena->Copy(reinterpret_cast<const char*>(s->Bytes()), s->Len());
+            else {
+                buf = new char[s->Len()];
+                memcpy(buf, s->Bytes(), s->Len());
+            }
 
             lval.val.string_val.data = buf;
             lval.val.string_val.length = s->Len();
@@ -1454,7 +1514,7 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
             const File* f = val->AsFile();
             const char* s = f->Name();
             auto len = strlen(s);
-            lval.val.string_val.data = util::copy_string(s, len);
+            lval.val.string_val.data = copy_log_string(s, len, arena);
             lval.val.string_val.length = len;
             break;
         }
@@ -1465,7 +1525,7 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
             f->Describe(&d);
             const char* s = d.Description();
             auto len = strlen(s);
-            lval.val.string_val.data = util::copy_string(s, len);
+            lval.val.string_val.data = copy_log_string(s, len, arena);
             lval.val.string_val.length = len;
             break;
         }
@@ -1488,7 +1548,7 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
 
             for ( zeek_int_t i = 0; i < lval.val.set_val.size; i++ ) {
                 std::optional<ZVal> s_i = ZVal(set->Idx(i), set_t);
-                lval.val.set_val.vals[i] = new threading::Value(ValToLogVal(s_i, set_t.get()));
+                lval.val.set_val.vals[i] = new threading::Value(ValToLogVal(s_i, set_t.get(), arena));
                 if ( is_managed )
                     ZVal::DeleteManagedType(*s_i);
             }
@@ -1505,7 +1565,7 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
             auto& vt = vec->GetType()->Yield();
 
             for ( zeek_int_t i = 0; i < lval.val.vector_val.size; i++ ) {
-                lval.val.vector_val.vals[i] = new threading::Value(ValToLogVal(vv[i], vt.get()));
+                lval.val.vector_val.vals[i] = new threading::Value(ValToLogVal(vv[i], vt.get(), arena));
             }
 
             break;
@@ -1517,7 +1577,8 @@ threading::Value Manager::ValToLogVal(std::optional<ZVal>& val, Type* ty) {
     return lval;
 }
 
-detail::LogRecord Manager::RecordToLogRecord(const Stream* stream, Filter* filter, RecordVal* columns) {
+detail::LogRecord Manager::RecordToLogRecord(const Stream* stream, Filter* filter, RecordVal* columns,
+                                             detail::StringArena* arena) {
     RecordValPtr ext_rec;
 
     if ( filter->num_ext_fields > 0 ) {
@@ -1567,7 +1628,7 @@ detail::LogRecord Manager::RecordToLogRecord(const Stream* stream, Filter* filte
         }
 
         if ( val )
-            vals.emplace_back(ValToLogVal(val, vt));
+            vals.emplace_back(ValToLogVal(val, vt, arena));
     }
 
     return vals;
@@ -2076,6 +2137,35 @@ void Manager::FlushAllWriteBuffers() {
     }
 }
 
+bool Manager::PostProcessRotatedFile(const std::string& fname) {
+    if ( ! rotation_postprocessor ) {
+        detail::RotationPostProcessor::Options options;
+        options.num_threads = std::max(BifConst::Log::rotation_postprocessing_threads, static_cast<zeek_uint_t>(1));
+        options.gzip_level = static_cast<int>(BifConst::Log::rotation_postprocessing_gzip_level);
+        options.checksum = BifConst::Log::rotation_postprocessing_checksum;
+        options.idle_io = BifConst::Log::rotation_postprocessing_idle_io;
+
+        if ( options.gzip_level > 9 ) {
+            reporter->Error("invalid Log::rotation_postprocessing_gzip_level %d, must be between 0 and 9",
+                            options.gzip_level);
+            return false;
+        }
+
+        rotation_postprocessor = std::make_unique<detail::RotationPostProcessor>(options);
+    }
+
+    DBG_LOG(DBG_LOGGING, "Queuing rotated file %s for post-processing, %zu pending", fname.c_str(),
+            rotation_postprocessor->Pending());
+
+    rotation_postprocessor->Queue(fname);
+    return true;
+}
+
+void Manager::ReportRotationPostProcessing() {
+    if ( rotation_postprocessor )
+        rotation_postprocessor->ReportCompleted();
+}
+
 void Manager::StartLogFlushTimer() {
     double next_t = zeek::run_state::network_time + BifConst::Log::flush_interval;
     log_flush_timer = new detail::LogFlushWriteBufferTimer(next_t);
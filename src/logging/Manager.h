@@ -33,6 +33,7 @@ class RotationTimer;
 namespace detail {
 
 class LogFlushWriteBufferTimer;
+class RotationPostProcessor;
 
 class DelayInfo;
 
@@ -315,6 +316,18 @@ public:
      */
     bool Flush(EnumVal* id);
 
+    /**
+     * Queues a rotated log file for the built-in post-processing, see
+     * Log::builtin_rotation_postprocessor_func. The processing happens
+     * asynchronously on a set of worker threads.
+     *
+     * @param fname The path of the rotated file.
+     *
+     * This methods corresponds directly to the internal BiF defined in
+     * logging.bif, which just forwards here.
+     */
+    bool PostProcessRotatedFile(const std::string& fname);
+
     /**
      * Signals the manager to shutdown at Zeek's termination.
      */
@@ -373,6 +386,9 @@ protected:
     // Start the regular log flushing timer.
     void StartLogFlushTimer();
 
+    // Reports the results of post-processed rotated files.
+    void ReportRotationPostProcessing();
+
 private:
     struct Filter;
     struct Stream;
@@ -398,8 +414,9 @@ private:
     bool TraverseRecord(Stream* stream, Filter* filter, RecordType* rt, TableVal* include, TableVal* exclude,
                         const std::string& path, const std::list<int>& indices);
 
-    detail::LogRecord RecordToLogRecord(const Stream* stream, Filter* filter, RecordVal* columns);
-    threading::Value ValToLogVal(std::optional<ZVal>& val, Type* ty);
+    detail::LogRecord RecordToLogRecord(const Stream* stream, Filter* filter, RecordVal* columns,
+                                        detail::StringArena* arena = nullptr);
+    threading::Value ValToLogVal(std::optional<ZVal>& val, Type* ty, detail::StringArena* arena = nullptr);
 
     Stream* FindStream(EnumVal* id);
     void RemoveDisabledWriters(Stream* stream);
@@ -427,12 +444,16 @@ private:
 
     std::shared_ptr<telemetry::CounterFamily> total_log_stream_writes_family;
     std::shared_ptr<telemetry::CounterFamily> total_log_writer_writes_family;
+    std::shared_ptr<telemetry::CounterFamily> total_log_filter_predicate_drops_family;
 
     zeek_uint_t last_delay_token = 0;
     std::vector<detail::WriteContext> active_writes;
 
     // Timer for flushing write buffers of frontends.
     detail::LogFlushWriteBufferTimer* log_flush_timer = nullptr;
+
+    // Created when the first rotated file gets queued for post-processing.
+    std::unique_ptr<detail::RotationPostProcessor> rotation_postprocessor;
 };
 
 } // namespace logging
@@ -0,0 +1,580 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/logging/Predicate.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "zeek/ID.h"
+#include "zeek/IPAddr.h"
+#include "zeek/Type.h"
+#include "zeek/Val.h"
+#include "zeek/ZeekString.h"
+#include "zeek/util.h"
+
+namespace zeek::logging::detail {
+
+class PredicateNode {
+public:
+    virtual ~PredicateNode() = default;
+    virtual bool Eval(const RecordVal* rec) const = 0;
+};
+
+using NodePtr = std::unique_ptr<PredicateNode>;
+
+namespace {
+
+// The offsets leading to a potentially nested field of a log record.
+class FieldPath {
+public:
+    // Returns null if the field, or a record containing it, isn't set.
+    ValPtr Get(const RecordVal* rec) const {
+        for ( size_t i = 0; i + 1 < offsets.size(); ++i ) {
+            auto v = rec->GetField(offsets[i]);
+
+            if ( ! v )
+                return nullptr;
+
+            rec = v->AsRecordVal();
+        }
+
+        return rec->GetField(offsets.back());
+    }
+
+    std::vector<int> offsets;
+    TypePtr type;
+};
+
+class AndNode final : public PredicateNode {
+public:
+    AndNode(NodePtr arg_lhs, NodePtr arg_rhs) : lhs(std::move(arg_lhs)), rhs(std::move(arg_rhs)) {}
+    bool Eval(const RecordVal* rec) const override { return lhs->Eval(rec) && rhs->Eval(rec); }
+
+private:
+    NodePtr lhs;
+    NodePtr rhs;
+};
+
+class OrNode final : public PredicateNode {
+public:
+    OrNode(NodePtr arg_lhs, NodePtr arg_rhs) : lhs(std::move(arg_lhs)), rhs(std::move(arg_rhs)) {}
+    bool Eval(const RecordVal* rec) const override { return lhs->Eval(rec) || rhs->Eval(rec); }
+
+private:
+    NodePtr lhs;
+    NodePtr rhs;
+};
+
+class NotNode final : public PredicateNode {
+public:
+    explicit NotNode(NodePtr arg_op) : op(std::move(arg_op)) {}
+    bool Eval(const RecordVal* rec) const override { return ! op->Eval(rec); }
+
+private:
+    NodePtr op;
+};
+
+class CompareNode final : public PredicateNode {
+public:
+    enum Op { EQ, NE, LT, LE, GT, GE };
+
+    CompareNode(FieldPath arg_field, Op arg_op, ValPtr arg_val)
+        : field(std::move(arg_field)), op(arg_op), val(std::move(arg_val)) {}
+
+    bool Eval(const RecordVal* rec) const override {
+        auto v = field.Get(rec);
+
+        if ( ! v )
+            return false;
+
+        int c = Compare(v.get(), val.get());
+
+        switch ( op ) {
+            case EQ: return c == 0;
+            case NE: return c != 0;
+            case LT: return c < 0;
+            case LE: return c <= 0;
+            case GT: return c > 0;
+            case GE: return c >= 0;
+        }
+
+        return false;
+    }
+
+private:
+    template<typename T>
+    static int Order(const T& a, const T& b) {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+
+    int Compare(const Val* a, const Val* b) const {
+        switch ( field.type->Tag() ) {
+            case TYPE_BOOL:
+            case TYPE_INT:
+            case TYPE_ENUM: return Order(a->AsInt(), b->AsInt());
+
+            case TYPE_COUNT:
+            case TYPE_PORT: return Order(a->AsCount(), b->AsCount());
+
+            case TYPE_DOUBLE:
+            case TYPE_TIME:
+            case TYPE_INTERVAL: return Order(a->AsDouble(), b->AsDouble());
+
+            case TYPE_STRING: return Bstr_cmp(a->AsString(), b->AsString());
+
+            case TYPE_ADDR: return Order(a->AsAddr(), b->AsAddr());
+
+            // Only equality is supported for subnets.
+            case TYPE_SUBNET: return a->AsSubNet() == b->AsSubNet() ? 0 : 1;
+
+            default: return 1;
+        }
+    }
+
+    FieldPath field;
+    Op op;
+    ValPtr val;
+};
+
+class InNode final : public PredicateNode {
+public:
+    InNode(FieldPath arg_field, IPPrefix arg_prefix) : field(std::move(arg_field)), prefix(std::move(arg_prefix)) {}
+
+    bool Eval(const RecordVal* rec) const override {
+        auto v = field.Get(rec);
+        return v && prefix.Contains(v->AsAddr());
+    }
+
+private:
+    FieldPath field;
+    IPPrefix prefix;
+};
+
+class LocalNode final : public PredicateNode {
+public:
+    LocalNode(FieldPath arg_field, zeek::detail::IDPtr arg_local_nets)
+        : field(std::move(arg_field)), local_nets(std::move(arg_local_nets)) {}
+
+    bool Eval(const RecordVal* rec) const override {
+        auto v = field.Get(rec);
+
+        if ( ! v )
+            return false;
+
+        // Site::local_nets is an option, so look at its current value.
+        const auto& nets = local_nets->GetVal();
+        return nets && nets->AsTableVal()->Contains(v->AsAddr());
+    }
+
+private:
+    FieldPath field;
+    zeek::detail::IDPtr local_nets;
+};
+
+class SampleNode final : public PredicateNode {
+public:
+    explicit SampleNode(double rate) : threshold(rate * util::detail::max_random()) {}
+    bool Eval(const RecordVal* rec) const override { return util::detail::random_number() < threshold; }
+
+private:
+    double threshold;
+};
+
+// Recursive descent parser for predicate expressions.
+class Parser {
+public:
+    Parser(const std::string& arg_expr, const RecordType* arg_columns) : expr(arg_expr), columns(arg_columns) {}
+
+    NodePtr Parse() {
+        auto n = ParseOr();
+
+        SkipSpace();
+
+        if ( n && pos < expr.size() )
+            return Fail("unexpected input");
+
+        return n;
+    }
+
+    const std::string& Error() const { return error; }
+
+private:
+    NodePtr ParseOr() {
+        auto lhs = ParseAnd();
+
+        while ( lhs && Accept("||") ) {
+            auto rhs = ParseAnd();
+
+            if ( ! rhs )
+                return nullptr;
+
+            lhs = std::make_unique<OrNode>(std::move(lhs), std::move(rhs));
+        }
+
+        return lhs;
+    }
+
+    NodePtr ParseAnd() {
+        auto lhs = ParseUnary();
+
+        while ( lhs && Accept("&&") ) {
+            auto rhs = ParseUnary();
+
+            if ( ! rhs )
+                return nullptr;
+
+            lhs = std::make_unique<AndNode>(std::move(lhs), std::move(rhs));
+        }
+
+        return lhs;
+    }
+
+    NodePtr ParseUnary() {
+        if ( Accept("!") ) {
+            auto op = ParseUnary();
+            return op ? std::make_unique<NotNode>(std::move(op)) : nullptr;
+        }
+
+        if ( Accept("(") ) {
+            auto n = ParseOr();
+
+            if ( n && ! Accept(")") )
+                return Fail("expected ')'");
+
+            return n;
+        }
+
+        auto name = Name();
+
+        if ( name.empty() )
+            return Fail("expected field name");
+
+        if ( name == "local" && Accept("(") ) {
+            FieldPath field;
+
+            if ( ! ResolveField(Name(), &field) )
+                return nullptr;
+
+            if ( field.type->Tag() != TYPE_ADDR )
+                return Fail("local() requires an address field");
+
+            if ( ! Accept(")") )
+                return Fail("expected ')'");
+
+            const auto& local_nets = id::find("Site::local_nets");
+
+            if ( ! local_nets || local_nets->GetType()->Tag() != TYPE_TABLE )
+                return Fail("local() requires Site::local_nets");
+
+            return std::make_unique<LocalNode>(std::move(field), local_nets);
+        }
+
+        if ( name == "sample" && Accept("(") ) {
+            auto token = Literal();
+            char* end;
+            double rate = strtod(token.c_str(), &end);
+
+            if ( token.empty() || *end || rate < 0.0 || rate > 1.0 )
+                return Fail("sample() requires a rate between 0 and 1");
+
+            if ( ! Accept(")") )
+                return Fail("expected ')'");
+
+            return std::make_unique<SampleNode>(rate);
+        }
+
+        FieldPath field;
+
+        if ( ! ResolveField(name, &field) )
+            return nullptr;
+
+        bool negate = Accept("!in");
+
+        if ( negate || Accept("in") ) {
+            if ( field.type->Tag() != TYPE_ADDR )
+                return Fail("'in' requires an address field");
+
+            IPPrefix prefix;
+
+            if ( ! IPPrefix::ConvertString(Literal().c_str(), &prefix) )
+                return Fail("expected subnet");
+
+            NodePtr n = std::make_unique<InNode>(std::move(field), std::move(prefix));
+
+            if ( negate )
+                n = std::make_unique<NotNode>(std::move(n));
+
+            return n;
+        }
+
+        CompareNode::Op op;
+
+        if ( Accept("==") )
+            op = CompareNode::EQ;
+        else if ( Accept("!=") )
+            op = CompareNode::NE;
+        else if ( Accept("<=") )
+            op = CompareNode::LE;
+        else if ( Accept(">=") )
+            op = CompareNode::GE;
+        else if ( Accept("<") )
+            op = CompareNode::LT;
+        else if ( Accept(">") )
+            op = CompareNode::GT;
+        else
+            return Fail("expected comparison operator");
+
+        auto tag = field.type->Tag();
+
+        if ( op != CompareNode::EQ && op != CompareNode::NE && (tag == TYPE_BOOL || tag == TYPE_SUBNET) )
+            return Fail(util::fmt("ordering not supported for %s fields", type_name(tag)));
+
+        auto val = Constant(field.type);
+
+        if ( ! val )
+            return Fail(util::fmt("expected %s constant", type_name(tag)));
+
+        return std::make_unique<CompareNode>(std::move(field), op, std::move(val));
+    }
+
+    bool ResolveField(const std::string& name, FieldPath* field) {
+        const RecordType* rt = columns;
+        std::string::size_type start = 0;
+
+        while ( true ) {
+            auto end = name.find('.', start);
+            auto component = name.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+            if ( ! rt ) {
+                Fail(util::fmt("'%s' is not a record field", name.substr(0, start - 1).c_str()));
+                return false;
+            }
+
+            int offset = rt->FieldOffset(component.c_str());
+
+            if ( offset < 0 ) {
+                Fail(util::fmt("unknown field '%s'", name.c_str()));
+                return false;
+            }
+
+            field->offsets.push_back(offset);
+            field->type = rt->GetFieldType(offset);
+
+            if ( end == std::string::npos )
+                break;
+
+            rt = field->type->Tag() == TYPE_RECORD ? field->type->AsRecordType() : nullptr;
+            start = end + 1;
+        }
+
+        switch ( field->type->Tag() ) {
+            case TYPE_BOOL:
+            case TYPE_INT:
+            case TYPE_ENUM:
+            case TYPE_COUNT:
+            case TYPE_PORT:
+            case TYPE_DOUBLE:
+            case TYPE_TIME:
+            case TYPE_INTERVAL:
+            case TYPE_STRING:
+            case TYPE_ADDR:
+            case TYPE_SUBNET: return true;
+
+            default:
+                Fail(util::fmt("field '%s' has unsupported type %s", name.c_str(), type_name(field->type->Tag())));
+                return false;
+        }
+    }
+
+    // Converts the next literal into a constant of the given type.
+    ValPtr Constant(const TypePtr& t) {
+        if ( t->Tag() == TYPE_STRING ) {
+            SkipSpace();
+
+            if ( pos >= expr.size() || expr[pos] != '"' )
+                return nullptr;
+
+            std::string s;
+
+            for ( ++pos; pos < expr.size() && expr[pos] != '"'; ++pos ) {
+                if ( expr[pos] == '\\' && pos + 1 < expr.size() )
+                    ++pos;
+
+                s += expr[pos];
+            }
+
+            if ( pos >= expr.size() )
+                return nullptr;
+
+            ++pos;
+            return make_intrusive<StringVal>(s);
+        }
+
+        auto token = Literal();
+
+        if ( token.empty() )
+            return nullptr;
+
+        const char* s = token.c_str();
+        char* end = nullptr;
+
+        switch ( t->Tag() ) {
+            case TYPE_BOOL:
+                if ( token != "T" && token != "F" )
+                    return nullptr;
+
+                return val_mgr->Bool(token == "T");
+
+            case TYPE_INT: {
+                auto i = strtoll(s, &end, 10);
+                return *end ? nullptr : val_mgr->Int(i);
+            }
+
+            case TYPE_COUNT: {
+                auto c = strtoull(s, &end, 10);
+                return *end || *s == '-' ? nullptr : val_mgr->Count(c);
+            }
+
+            case TYPE_DOUBLE:
+            case TYPE_TIME:
+            case TYPE_INTERVAL: {
+                double d = strtod(s, &end);
+
+                if ( *end )
+                    return nullptr;
+
+                if ( t->Tag() == TYPE_TIME )
+                    return make_intrusive<TimeVal>(d);
+                if ( t->Tag() == TYPE_INTERVAL )
+                    return make_intrusive<IntervalVal>(d);
+
+                return make_intrusive<DoubleVal>(d);
+            }
+
+            case TYPE_PORT: {
+                auto p = strtoul(s, &end, 10);
+
+                if ( end == s || *end != '/' || p > 65535 )
+                    return nullptr;
+
+                std::string proto = end + 1;
+
+                if ( proto == "tcp" )
+                    return val_mgr->Port(p, TRANSPORT_TCP);
+                if ( proto == "udp" )
+                    return val_mgr->Port(p, TRANSPORT_UDP);
+                if ( proto == "icmp" )
+                    return val_mgr->Port(p, TRANSPORT_ICMP);
+                if ( proto == "unknown" )
+                    return val_mgr->Port(p, TRANSPORT_UNKNOWN);
+
+                return nullptr;
+            }
+
+            case TYPE_ADDR: {
+                in6_addr a;
+                return IPAddr::ConvertString(s, &a) ? make_intrusive<AddrVal>(IPAddr(a)) : nullptr;
+            }
+
+            case TYPE_SUBNET: {
+                IPPrefix p;
+                return IPPrefix::ConvertString(s, &p) ? make_intrusive<SubNetVal>(p) : nullptr;
+            }
+
+            case TYPE_ENUM: {
+                auto et = t->AsEnumType();
+                auto i = et->Lookup(token);
+                return i < 0 ? nullptr : et->GetEnumVal(i);
+            }
+
+            default: return nullptr;
+        }
+    }
+
+    void SkipSpace() {
+        while ( pos < expr.size() && isspace(expr[pos]) )
+            ++pos;
+    }
+
+    // Consumes the given token if it's next. Keywords must not be
+    // followed by further name characters.
+    bool Accept(const char* token) {
+        SkipSpace();
+
+        auto n = strlen(token);
+
+        if ( expr.compare(pos, n, token) != 0 )
+            return false;
+
+        if ( isalpha(token[n - 1]) && pos + n < expr.size() && IsNameChar(expr[pos + n]) )
+            return false;
+
+        // Don't take "!=" or "!in" for a negation.
+        if ( n == 1 && token[0] == '!' && pos + 1 < expr.size() && expr[pos + 1] == '=' )
+            return false;
+
+        pos += n;
+        return true;
+    }
+
+    static bool IsNameChar(char c) { return isalnum(c) || c == '_' || c == '.'; }
+
+    std::string Name() {
+        SkipSpace();
+
+        auto start = pos;
+
+        while ( pos < expr.size() && IsNameChar(expr[pos]) )
+            ++pos;
+
+        return expr.substr(start, pos - start);
+    }
+
+    std::string Literal() {
+        SkipSpace();
+
+        auto start = pos;
+
+        while ( pos < expr.size() && ! isspace(expr[pos]) && ! strchr(")&|", expr[pos]) )
+            ++pos;
+
+        return expr.substr(start, pos - start);
+    }
+
+    NodePtr Fail(const std::string& msg) {
+        if ( error.empty() )
+            error = util::fmt("%s at offset %zu", msg.c_str(), pos);
+
+        return nullptr;
+    }
+
+    const std::string& expr;
+    const RecordType* columns;
+    std::string::size_type pos = 0;
+    std::string error;
+};
+
+} // namespace
+
+Predicate::Predicate(std::string arg_expr, std::unique_ptr<PredicateNode> arg_root)
+    : expr(std::move(arg_expr)), root(std::move(arg_root)) {}
+
+Predicate::~Predicate() = default;
+
+std::unique_ptr<Predicate> Predicate::Compile(const std::string& expr, const RecordType* columns, std::string* error) {
+    Parser parser(expr, columns);
+    auto root = parser.Parse();
+
+    if ( ! root ) {
+        *error = parser.Error();
+        return nullptr;
+    }
+
+    return std::unique_ptr<Predicate>(new Predicate(expr, std::move(root)));
+}
+
+bool Predicate::Eval(const RecordVal* rec) const { return root->Eval(rec); }
+
+} // namespace zeek::logging::detail
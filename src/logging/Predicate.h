@@ -0,0 +1,73 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Native log filter predicates.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "zeek/IntrusivePtr.h"
+
+namespace zeek {
+
+class RecordType;
+class RecordVal;
+
+namespace logging::detail {
+
+class PredicateNode;
+
+/**
+ * A predicate compiled from the *predicate* field of a Log::Filter. It gets
+ * evaluated directly against a stream's log records, before the filter's
+ * policy hook runs.
+ *
+ * The language consists of comparisons of a log field against a constant
+ * (``==``, ``!=``, ``<``, ``<=``, ``>``, ``>=``), subnet membership of an
+ * address field (``in``, ``!in``), ``local(field)`` for membership in
+ * Site::local_nets, ``sample(rate)``, and ``&&``, ``||``, ``!`` and
+ * parentheses to combine these. Fields are named by their path within the
+ * columns record, such as ``id.orig_h``. Constants use Zeek's script syntax
+ * for the field's type. A comparison on a field that's not set is false.
+ */
+class Predicate {
+public:
+    /**
+     * Compiles a predicate for records of the given type.
+     *
+     * @param expr The expression.
+     *
+     * @param columns The record type of the log records.
+     *
+     * @param error Set to a description of the problem if compilation fails.
+     *
+     * @return The predicate, or null if the expression isn't valid.
+     */
+    static std::unique_ptr<Predicate> Compile(const std::string& expr, const RecordType* columns, std::string* error);
+
+    ~Predicate();
+
+    /**
+     * Evaluates the predicate.
+     *
+     * @param rec A log record of the type the predicate was compiled for.
+     *
+     * @return True if the record is to be logged.
+     */
+    bool Eval(const RecordVal* rec) const;
+
+    /**
+     * @return The expression the predicate was compiled from.
+     */
+    const std::string& Expr() const { return expr; }
+
+private:
+    Predicate(std::string expr, std::unique_ptr<PredicateNode> root);
+
+    std::string expr;
+    std::unique_ptr<PredicateNode> root;
+};
+
+} // namespace logging::detail
+} // namespace zeek
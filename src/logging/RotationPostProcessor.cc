@@ -0,0 +1,325 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/logging/RotationPostProcessor.h"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "zeek/DebugLogger.h"
+#include "zeek/Reporter.h"
+#include "zeek/digest.h"
+#include "zeek/telemetry/Manager.h"
+#include "zeek/threading/BasicThread.h"
+#include "zeek/util.h"
+
+namespace zeek::logging::detail {
+
+// Size of the buffer files are read with.
+static constexpr size_t READ_BUFFER_SIZE = 64 * 1024;
+
+// Lowers the CPU and IO priority of the calling thread. This is best
+// effort: where the priorities can't be set per thread, nothing happens.
+static void lower_thread_priority() {
+#ifdef __linux__
+    // On Linux, both the nice value and the IO priority of a "process"
+    // apply to the individual thread.
+    auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    setpriority(PRIO_PROCESS, tid, 10);
+
+#ifdef SYS_ioprio_set
+    constexpr int IOPRIO_WHO_PROCESS = 1;
+    constexpr int IOPRIO_CLASS_IDLE = 3;
+    constexpr int IOPRIO_CLASS_SHIFT = 13;
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+#endif
+}
+
+// Formats an error message. This runs on the worker threads, so it can't
+// use util::fmt().
+static std::string error_msg(const char* what, const std::string& fname, const char* reason) {
+    return std::string(what) + " " + fname + ": " + reason;
+}
+
+static std::string errno_error(const char* what, const std::string& fname) {
+    char buf[256];
+    util::zeek_strerror_r(errno, buf, sizeof(buf));
+    return error_msg(what, fname, buf);
+}
+
+RotationPostProcessor::RotationPostProcessor(const Options& arg_options) : options(arg_options) {
+    lag_metric = telemetry_mgr->HistogramInstance("zeek", "log_rotation_postprocessing_lag", {},
+                                                  {0.1, 1.0, 10.0, 60.0, 300.0, 1800.0},
+                                                  "Time between queuing a rotated log file for post-processing and "
+                                                  "completing it",
+                                                  "seconds");
+    failures_metric = telemetry_mgr->CounterInstance("zeek", "log_rotation_postprocessing_failures", {},
+                                                     "Number of rotated log files that failed post-processing");
+
+    for ( size_t i = 0; i < options.num_threads; i++ )
+        threads.emplace_back([this]() {
+            threading::BasicThread::BlockSignals();
+            util::detail::set_thread_name("zk.log-rotate");
+
+            if ( options.idle_io )
+                lower_thread_priority();
+
+            Work();
+        });
+}
+
+RotationPostProcessor::~RotationPostProcessor() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+
+    work_cv.notify_all();
+
+    for ( auto& t : threads )
+        t.join();
+
+    ReportCompleted();
+}
+
+void RotationPostProcessor::Queue(std::string fname) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        jobs.push_back({std::move(fname), std::chrono::steady_clock::now()});
+    }
+
+    work_cv.notify_one();
+}
+
+void RotationPostProcessor::ReportCompleted() {
+    std::vector<Result> done;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done.swap(results);
+    }
+
+    for ( const auto& r : done ) {
+        if ( r.error.empty() )
+            DBG_LOG(DBG_LOGGING, "Finished post-processing rotated file %s", r.fname.c_str());
+        else
+            reporter->Error("failed to post-process rotated log file %s: %s", r.fname.c_str(), r.error.c_str());
+    }
+}
+
+size_t RotationPostProcessor::Pending() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return jobs.size() + active;
+}
+
+void RotationPostProcessor::Work() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while ( true ) {
+        // Keep going while stopping so that all queued files get processed.
+        work_cv.wait(lock, [this]() { return stopping || ! jobs.empty(); });
+
+        if ( jobs.empty() )
+            return;
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        ++active;
+
+        lock.unlock();
+        auto error = Process(job.fname);
+        std::chrono::duration<double> lag = std::chrono::steady_clock::now() - job.queued;
+        lag_metric->Observe(lag.count());
+
+        if ( ! error.empty() )
+            failures_metric->Inc();
+
+        lock.lock();
+
+        --active;
+        results.push_back({std::move(job.fname), std::move(error)});
+    }
+}
+
+std::string RotationPostProcessor::Process(const std::string& fname) {
+    std::string final_name = fname;
+    std::string digest;
+
+    if ( options.gzip_level > 0 ) {
+        final_name = fname + ".gz";
+
+        if ( auto error = Compress(fname, final_name, options.checksum ? &digest : nullptr); ! error.empty() )
+            return error;
+
+        if ( unlink(fname.c_str()) < 0 )
+            return errno_error("cannot remove", fname);
+    }
+    else if ( options.checksum ) {
+        if ( auto error = Checksum(fname, &digest); ! error.empty() )
+            return error;
+    }
+
+    if ( options.checksum )
+        return WriteChecksumFile(final_name, digest);
+
+    return "";
+}
+
+std::string RotationPostProcessor::Compress(const std::string& src, const std::string& dst, std::string* digest) {
+    int in = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if ( in < 0 )
+        return errno_error("cannot open", src);
+
+    std::string tmp = dst + ".tmp";
+    int out = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if ( out < 0 ) {
+        auto error = errno_error("cannot open", tmp);
+        close(in);
+        return error;
+    }
+
+    char mode[8];
+    snprintf(mode, sizeof(mode), "wb%d", options.gzip_level);
+
+    gzFile gz = gzdopen(out, mode);
+    if ( ! gz ) {
+        close(in);
+        close(out);
+        unlink(tmp.c_str());
+        return error_msg("cannot gzip", tmp, "gzdopen failed");
+    }
+
+    std::string error;
+    std::vector<char> buf(READ_BUFFER_SIZE);
+
+    while ( true ) {
+        ssize_t n = read(in, buf.data(), buf.size());
+
+        if ( n < 0 ) {
+            if ( errno == EINTR )
+                continue;
+
+            error = errno_error("cannot read", src);
+            break;
+        }
+
+        if ( n == 0 )
+            break;
+
+        if ( gzwrite(gz, buf.data(), static_cast<unsigned>(n)) != n ) {
+            int err;
+            error = error_msg("cannot write", tmp, gzerror(gz, &err));
+            break;
+        }
+    }
+
+    close(in);
+
+    // Make sure the data is on disk before the rename makes it visible.
+    if ( error.empty() && gzflush(gz, Z_FINISH) != Z_OK ) {
+        int err;
+        error = error_msg("cannot write", tmp, gzerror(gz, &err));
+    }
+
+    if ( error.empty() && fsync(out) < 0 )
+        error = errno_error("cannot sync", tmp);
+
+    if ( gzclose(gz) != Z_OK && error.empty() )
+        error = error_msg("cannot close", tmp, "gzclose failed");
+
+    if ( error.empty() && digest )
+        error = Checksum(tmp, digest);
+
+    if ( error.empty() && rename(tmp.c_str(), dst.c_str()) < 0 )
+        error = errno_error("cannot rename", tmp);
+
+    if ( ! error.empty() )
+        unlink(tmp.c_str());
+
+    return error;
+}
+
+std::string RotationPostProcessor::Checksum(const std::string& fname, std::string* digest) {
+    int fd = open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+    if ( fd < 0 )
+        return errno_error("cannot open", fname);
+
+    auto* state = zeek::detail::hash_init(zeek::detail::Hash_SHA256);
+    std::vector<char> buf(READ_BUFFER_SIZE);
+    std::string error;
+
+    while ( true ) {
+        ssize_t n = read(fd, buf.data(), buf.size());
+
+        if ( n < 0 ) {
+            if ( errno == EINTR )
+                continue;
+
+            error = errno_error("cannot read", fname);
+            break;
+        }
+
+        if ( n == 0 )
+            break;
+
+        zeek::detail::hash_update(state, buf.data(), n);
+    }
+
+    close(fd);
+
+    u_char md[ZEEK_SHA256_DIGEST_LENGTH];
+    zeek::detail::hash_final(state, md);
+
+    if ( ! error.empty() )
+        return error;
+
+    // digest_print() uses a static buffer, so convert here.
+    char hex[2 * ZEEK_SHA256_DIGEST_LENGTH + 1];
+    for ( size_t i = 0; i < ZEEK_SHA256_DIGEST_LENGTH; i++ )
+        util::bytetohex(md[i], &hex[i * 2]);
+    hex[2 * ZEEK_SHA256_DIGEST_LENGTH] = '\0';
+
+    digest->assign(hex);
+    return "";
+}
+
+std::string RotationPostProcessor::WriteChecksumFile(const std::string& fname, const std::string& digest) {
+    // Same format as sha256sum(1), so the file can be verified with "sha256sum -c".
+    auto slash = fname.find_last_of('/');
+    auto base = slash == std::string::npos ? fname : fname.substr(slash + 1);
+    std::string content = digest + "  " + base + "\n";
+    std::string dst = fname + ".sha256";
+    std::string tmp = dst + ".tmp";
+
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if ( fd < 0 )
+        return errno_error("cannot open", tmp);
+
+    std::string error;
+
+    if ( ! util::safe_write(fd, content.data(), content.size()) )
+        error = errno_error("cannot write", tmp);
+    else if ( fsync(fd) < 0 )
+        error = errno_error("cannot sync", tmp);
+
+    close(fd);
+
+    if ( error.empty() && rename(tmp.c_str(), dst.c_str()) < 0 )
+        error = errno_error("cannot rename", tmp);
+
+    if ( ! error.empty() )
+        unlink(tmp.c_str());
+
+    return error;
+}
+
+} // namespace zeek::logging::detail
@@ -0,0 +1,107 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zeek {
+
+namespace telemetry {
+class Counter;
+using CounterPtr = std::shared_ptr<Counter>;
+class Histogram;
+using HistogramPtr = std::shared_ptr<Histogram>;
+} // namespace telemetry
+
+namespace logging::detail {
+
+/**
+ * A bounded set of threads post-processing rotated log files, used by
+ * Log::builtin_rotation_postprocessor_func.
+ *
+ * For each file, a worker optionally gzip-compresses it and writes a
+ * SHA256 checksum file next to it. All output is first written to a
+ * temporary file that is then renamed into place, so that a file under
+ * its final name is always complete. The workers may run with idle IO
+ * priority so that they don't compete with the writers.
+ */
+class RotationPostProcessor {
+public:
+    struct Options {
+        size_t num_threads = 1;
+        int gzip_level = 0;
+        bool checksum = false;
+        bool idle_io = false;
+    };
+
+    /**
+     * Constructor. Starts the worker threads.
+     */
+    explicit RotationPostProcessor(const Options& options);
+
+    /**
+     * Destructor. Processes all queued files, stops the worker threads
+     * and reports outstanding results.
+     */
+    ~RotationPostProcessor();
+
+    /**
+     * Queues a rotated file for post-processing. Must be called from the
+     * main thread.
+     *
+     * @param fname The path of the rotated file.
+     */
+    void Queue(std::string fname);
+
+    /**
+     * Reports errors of files processed since the last call through the
+     * reporter. Must be called from the main thread.
+     */
+    void ReportCompleted();
+
+    /**
+     * @return The number of files queued or being processed.
+     */
+    size_t Pending();
+
+private:
+    struct Job {
+        std::string fname;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    struct Result {
+        std::string fname;
+        std::string error; // Empty if successful.
+    };
+
+    void Work();
+    std::string Process(const std::string& fname);
+    std::string Compress(const std::string& src, const std::string& dst, std::string* digest);
+    std::string Checksum(const std::string& fname, std::string* digest);
+    std::string WriteChecksumFile(const std::string& fname, const std::string& digest);
+
+    Options options;
+
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::deque<Job> jobs;
+    std::vector<Result> results;
+    size_t active = 0;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    telemetry::HistogramPtr lag_metric;
+    telemetry::CounterPtr failures_metric;
+};
+
+} // namespace logging::detail
+} // namespace zeek
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "zeek/Span.h"
 #include "zeek/logging/Component.h"
 #include "zeek/threading/MsgThread.h"
@@ -18,6 +23,89 @@ namespace detail {
 
 using LogRecord = std::vector<threading::Value>;
 
+/**
+ * Storage for the string data of a batch of log records. The strings get
+ * carved out of larger chunks that are released all at once when the batch
+ * is done, instead of each value allocating and freeing its own copy.
+ * Values referring to the arena are flagged as borrowed.
+ */
+class StringArena {
+public:
+    StringArena() = default;
+
+    StringArena(StringArena&& other) noexcept
+        : chunks(std::move(other.chunks)),
+          next(std::exchange(other.next, nullptr)),
+          avail(std::exchange(other.avail, 0)),
+          allocated(std::exchange(other.allocated, 0)) {
+        other.chunks.clear();
+    }
+
+    StringArena& operator=(StringArena&& other) noexcept {
+        chunks = std::move(other.chunks);
+        next = std::exchange(other.next, nullptr);
+        avail = std::exchange(other.avail, 0);
+        allocated = std::exchange(other.allocated, 0);
+        other.chunks.clear();
+        return *this;
+    }
+
+    /**
+     * Copies a string into the arena.
+     *
+     * @param s The string, which doesn't need to be null-terminated.
+     *
+     * @param len The length of the string.
+     *
+     * @return The copy, with a terminating null byte appended.
+     */
+    char* Copy(const char* s, size_t len) {
+        char* dst = Allocate(len + 1);
+        memcpy(dst, s, len);
+        dst[len] = '\0';
+        return dst;
+    }
+
+    /**
+     * @return True if nothing has been allocated from the arena.
+     */
+    bool Empty() const { return chunks.empty(); }
+
+    /**
+     * @return The number of bytes the arena has allocated for its chunks.
+     */
+    size_t Allocated() const { return allocated; }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+    char* Allocate(size_t len) {
+        if ( len > CHUNK_SIZE / 4 ) {
+            // Large strings get a chunk of their own.
+            chunks.emplace_back(new char[len]);
+            allocated += len;
+            return chunks.back().get();
+        }
+
+        if ( len > avail ) {
+            chunks.emplace_back(new char[CHUNK_SIZE]);
+            next = chunks.back().get();
+            avail = CHUNK_SIZE;
+            allocated += CHUNK_SIZE;
+        }
+
+        char* p = next;
+        next += len;
+        avail -= len;
+        return p;
+    }
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* next = nullptr;
+    size_t avail = 0;
+    size_t allocated = 0;
+};
+
 }
 
 class WriterFrontend;
@@ -252,6 +340,7 @@ public:
     // Overridden from MsgThread.
     bool OnHeartbeat(double network_time, double current_time) override;
     bool OnFinish(double network_time) override;
+    bool CanRunOnPool() const override { return true; }
 
     // Let the compiler know that we are aware that there is a virtual
     // info function in the base.
@@ -1,5 +1,6 @@
 #include "zeek/logging/WriterFrontend.h"
 
+#include "zeek/MemoryAccounting.h"
 #include "zeek/RunState.h"
 #include "zeek/Span.h"
 #include "zeek/broker/Manager.h"
@@ -51,15 +52,18 @@ private:
 
 class WriteMessage final : public threading::InputMessage<WriterBackend> {
 public:
-    WriteMessage(WriterBackend* backend, int num_fields, std::vector<detail::LogRecord>&& records)
+    WriteMessage(WriterBackend* backend, int num_fields, std::vector<detail::LogRecord>&& records,
+                 detail::StringArena&& arena)
         : threading::InputMessage<WriterBackend>("Write", backend),
           num_fields(num_fields),
+          arena(std::move(arena)),
           records(std::move(records)) {}
 
     bool Process() override { return Object()->Write(num_fields, zeek::Span{records}); }
 
 private:
     int num_fields;
+    detail::StringArena arena; // Declared before the records so that it outlives them.
     std::vector<detail::LogRecord> records;
 };
 
@@ -87,6 +91,11 @@ private:
 
 // Frontend methods.
 
+void detail::WriteBuffer::WriteRecord(LogRecord&& record) {
+    record_bytes += sizeof(LogRecord) + record.capacity() * sizeof(Value);
+    records.emplace_back(std::move(record));
+}
+
 WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVal* arg_stream, EnumVal* arg_writer,
                                bool arg_local, bool arg_remote)
     : write_buffer(detail::WriteBuffer(BifConst::Log::write_buffer_size)) {
@@ -119,6 +128,8 @@ WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVa
 }
 
 WriterFrontend::~WriterFrontend() {
+    zeek::detail::memory_freed(zeek::detail::MemoryTag::LogBuffer, accounted_bytes);
+
     for ( auto i = 0; i < num_fields; ++i )
         delete fields[i];
 
@@ -191,6 +202,12 @@ void WriterFrontend::Write(detail::LogRecord&& arg_vals) {
 
     write_buffer.WriteRecord(std::move(vals));
 
+    // The record's strings have been copied into the buffer's arena
+    // already, so this covers them, too.
+    auto bytes = write_buffer.Bytes();
+    zeek::detail::memory_allocated(zeek::detail::MemoryTag::LogBuffer, bytes - accounted_bytes);
+    accounted_bytes = bytes;
+
     if ( write_buffer.Full() || ! buf || run_state::terminating )
         // Buffer full (or no buffering desired or terminating).
         FlushWriteBuffer();
@@ -204,8 +221,13 @@ void WriterFrontend::FlushWriteBuffer() {
         // Nothing to do.
         return;
 
-    if ( backend )
-        backend->SendIn(new WriteMessage(backend, num_fields, std::move(write_buffer).TakeRecords()));
+    if ( backend ) {
+        zeek::detail::memory_freed(zeek::detail::MemoryTag::LogBuffer, accounted_bytes);
+        accounted_bytes = 0;
+
+        backend->SendIn(new WriteMessage(backend, num_fields, std::move(write_buffer).TakeRecords(),
+                                         std::move(write_buffer).TakeArena()));
+    }
 }
 
 void WriterFrontend::SetBuf(bool enabled) {
@@ -29,7 +29,7 @@ public:
      *
      * @param record The records vals.
      */
-    void WriteRecord(LogRecord&& record) { records.emplace_back(std::move(record)); }
+    void WriteRecord(LogRecord&& record);
 
     /**
      * Moves the records out of the buffer and resets it.
@@ -42,10 +42,34 @@ public:
         // Re-initialize the buffer.
         records.clear();
         records.reserve(buffer_size);
+        record_bytes = 0;
 
         return tmp;
     }
 
+    /**
+     * Moves the string arena of the buffered records out of the buffer.
+     * This needs to travel with the records returned by TakeRecords().
+     *
+     * @return The arena holding the buffered records' borrowed strings.
+     */
+    StringArena TakeArena() && {
+        auto tmp = std::move(arena);
+        arena = StringArena();
+        return tmp;
+    }
+
+    /**
+     * @return The arena for strings of records to be added to the buffer.
+     */
+    StringArena* Arena() { return &arena; }
+
+    /**
+     * @return The approximate number of bytes taken by the buffered records,
+     * including their strings.
+     */
+    size_t Bytes() const { return record_bytes + arena.Allocated(); }
+
     /**
      * @return The size of the buffer.
      */
@@ -64,6 +88,8 @@ public:
 private:
     size_t buffer_size;
     std::vector<LogRecord> records;
+    size_t record_bytes = 0;
+    StringArena arena;
 };
 
 } // namespace detail
@@ -220,6 +246,16 @@ public:
      */
     bool Disabled() { return disabled; }
 
+    /**
+     * Returns the arena that strings of a record passed to the next Write()
+     * may be placed in, or null if the record's values need to own their
+     * data. The arena gets handed to the backend along with the batch the
+     * record ends up in.
+     *
+     * This method must only be called from the main thread.
+     */
+    detail::StringArena* Arena() { return backend && ! disabled ? write_buffer.Arena() : nullptr; }
+
     /**
      * Returns the additional writer information as passed into the constructor.
      */
@@ -262,6 +298,7 @@ protected:
     const threading::Field* const* fields; // The log fields.
 
     detail::WriteBuffer write_buffer; // Buffer for bulk writes.
+    size_t accounted_bytes = 0;       // Bytes of write_buffer reported to memory accounting.
 };
 
 } // namespace zeek::logging
@@ -4,7 +4,10 @@
 
 #include "zeek/zeek-config.h"
 
+#include <strings.h>
+#include <algorithm>
 #include <cerrno>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -18,7 +21,8 @@ using zeek::threading::Value;
 
 namespace zeek::logging::writer::detail {
 
-SQLite::SQLite(WriterFrontend* frontend) : WriterBackend(frontend), fields(), num_fields(), db(), st() {
+SQLite::SQLite(WriterFrontend* frontend)
+    : WriterBackend(frontend), fields(), num_fields(), db(), st(), batch_size(1), pending(0) {
     set_separator.assign((const char*)BifConst::LogSQLite::set_separator->Bytes(),
                          BifConst::LogSQLite::set_separator->Len());
 
@@ -32,6 +36,9 @@ SQLite::SQLite(WriterFrontend* frontend) : WriterBackend(frontend), fields(), nu
 
 SQLite::~SQLite() {
     if ( db != 0 ) {
+        if ( pending > 0 )
+            sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+
         sqlite3_finalize(st);
         if ( ! sqlite3_close(db) )
             Error("Sqlite could not close connection");
@@ -124,10 +131,35 @@ bool SQLite::DoInit(const WriterInfo& info, int arg_num_fields, const Field* con
     else
         tablename = it->second;
 
+    batch_size = BifConst::LogSQLite::batch_size;
+    it = info.config.find("batch_size");
+    if ( it != info.config.end() )
+        batch_size = strtoull(it->second, nullptr, 10);
+
+    string journal_mode(reinterpret_cast<const char*>(BifConst::LogSQLite::journal_mode->Bytes()),
+                        BifConst::LogSQLite::journal_mode->Len());
+    it = info.config.find("journal_mode");
+    if ( it != info.config.end() )
+        journal_mode = it->second;
+
     if ( checkError(sqlite3_open_v2(fullpath.string().c_str(), &db,
                                     SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL)) )
         return false;
 
+    if ( ! journal_mode.empty() ) {
+        static const char* journal_modes[] = {"delete", "truncate", "persist", "memory", "wal", "off"};
+
+        if ( std::none_of(std::begin(journal_modes), std::end(journal_modes),
+                          [&](const char* m) { return strcasecmp(m, journal_mode.c_str()) == 0; }) ) {
+            Error(Fmt("Invalid SQLite journal mode %s", journal_mode.c_str()));
+            return false;
+        }
+
+        string pragma = "PRAGMA journal_mode=" + journal_mode + ";";
+        if ( checkError(sqlite3_exec(db, pragma.c_str(), NULL, NULL, NULL)) )
+            return false;
+    }
+
     string create = "CREATE TABLE IF NOT EXISTS " + tablename + " (\n";
     //"id SERIAL UNIQUE NOT NULL"; // SQLite has rowids, we do not need a counter here.
 
@@ -290,27 +322,71 @@ int SQLite::AddParams(Value* val, int pos) {
 }
 
 bool SQLite::DoWrite(int num_fields, const Field* const* fields, Value** vals) {
+    // Group writes into transactions, rather than having SQLite commit
+    // each one individually.
+    if ( batch_size > 1 && pending == 0 ) {
+        if ( checkError(sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL)) )
+            return false;
+    }
+
     // bind parameters
     for ( int i = 0; i < num_fields; i++ ) {
         if ( checkError(AddParams(vals[i], i + 1)) )
-            return false;
+            return WriteFailed();
     }
 
     // execute query
     if ( checkError(sqlite3_step(st)) )
-        return false;
+        return WriteFailed();
 
     // clean up and make ready for next query execution
     if ( checkError(sqlite3_clear_bindings(st)) )
-        return false;
+        return WriteFailed();
 
     if ( checkError(sqlite3_reset(st)) )
-        return false;
+        return WriteFailed();
+
+    if ( batch_size > 1 && (++pending >= batch_size || ! IsBuf()) )
+        return Commit();
+
+    return true;
+}
+
+bool SQLite::Commit() {
+    if ( sqlite3_get_autocommit(db) )
+        return true;
+
+    auto rows = pending;
+    pending = 0;
+
+    if ( ! checkError(sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL)) )
+        return true;
+
+    // Don't leave the transaction open, subsequent writes would end up in
+    // it as well.
+    sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    Error(Fmt("rolled back transaction, lost %" PRIu64 " rows", rows));
+    return false;
+}
+
+bool SQLite::WriteFailed() {
+    sqlite3_reset(st);
+    sqlite3_clear_bindings(st);
+    Commit();
+    return false;
+}
+
+bool SQLite::DoSetBuf(bool enabled) {
+    if ( ! enabled )
+        return Commit();
 
     return true;
 }
 
 bool SQLite::DoRotate(const char* rotated_path, double open, double close, bool terminating) {
+    if ( ! Commit() )
+        return false;
+
     if ( ! FinishedRotation("/dev/null", Info().path, open, close, terminating) ) {
         Error(Fmt("error rotating %s", Info().path));
         return false;
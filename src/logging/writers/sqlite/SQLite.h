@@ -23,15 +23,23 @@ public:
 protected:
     bool DoInit(const WriterInfo& info, int arg_num_fields, const threading::Field* const* arg_fields) override;
     bool DoWrite(int num_fields, const threading::Field* const* fields, threading::Value** vals) override;
-    bool DoSetBuf(bool enabled) override { return true; }
+    bool DoSetBuf(bool enabled) override;
     bool DoRotate(const char* rotated_path, double open, double close, bool terminating) override;
-    bool DoFlush(double network_time) override { return true; }
-    bool DoFinish(double network_time) override { return true; }
-    bool DoHeartbeat(double network_time, double current_time) override { return true; }
+    bool DoFlush(double network_time) override { return Commit(); }
+    bool DoFinish(double network_time) override { return Commit(); }
+    bool DoHeartbeat(double network_time, double current_time) override { return Commit(); }
 
 private:
     bool checkError(int code);
 
+    // Commits the open transaction, if any. If that fails, rolls it back
+    // and reports the rows lost.
+    bool Commit();
+
+    // Called when writing a row failed. Commits the rows of the open
+    // transaction written before, since the writer gets disabled.
+    bool WriteFailed();
+
     int AddParams(threading::Value* val, int pos);
     std::string GetTableType(int, int);
 
@@ -45,6 +53,11 @@ private:
     std::string unset_field;
     std::string empty_field;
 
+    // Number of writes to group into one transaction, and the number
+    // of writes in the currently open transaction.
+    zeek_uint_t batch_size;
+    zeek_uint_t pending;
+
     threading::formatter::Ascii* io;
 };
 
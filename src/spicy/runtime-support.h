@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <limits>
 #include <optional>
 #include <ostream>
@@ -13,6 +14,7 @@
 #include <string_view>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include <hilti/rt/deferred-expression.h>
 #include <hilti/rt/exception.h>
@@ -771,6 +773,42 @@ struct is_instance_impl<U<Ts...>, U> : std::true_type {};
 template<typename T, template<typename...> typename U>
 using is_instance = is_instance_impl<std::remove_cv_t<T>, U>;
 
+namespace detail {
+
+/**
+ * Remembers the Zeek record types that a particular Spicy struct type has
+ * already been successfully converted into. The mapping of Spicy fields to
+ * record fields depends only on the two types, so once a conversion has
+ * checked it, later conversions into the same record type can skip
+ * comparing field names. This is typically a single entry per struct type:
+ * the type of the event parameter the struct gets passed to.
+ */
+class RecordConversionCache {
+public:
+    bool IsVerified(const RecordType* rtype) const {
+        return std::any_of(verified.begin(), verified.end(), [rtype](const auto& t) { return t.get() == rtype; });
+    }
+
+    void SetVerified(const IntrusivePtr<RecordType>& rtype) {
+        if ( ! IsVerified(rtype.get()) )
+            verified.push_back(rtype);
+    }
+
+private:
+    // Holding references keeps a verified type's address from getting
+    // reused by a different type.
+    std::vector<IntrusivePtr<RecordType>> verified;
+};
+
+/** Returns the conversion cache for Spicy struct type `T`. */
+template<typename T>
+RecordConversionCache& record_conversion_cache() {
+    static RecordConversionCache cache;
+    return cache;
+}
+
+} // namespace detail
+
 template<typename T>
 inline void set_record_field(RecordVal* rval, const IntrusivePtr<RecordType>& rtype, int idx, const T& x) {
     using NoConversionNeeded = std::integral_constant<
@@ -830,7 +868,7 @@ inline void set_record_field(RecordVal* rval, const IntrusivePtr<RecordType>& rt
         else {
             // Field must be &optional or &default.
             if ( auto attrs = rtype->FieldDecl(idx)->attrs;
-                 ! attrs || ! (attrs->Find(detail::ATTR_DEFAULT) || attrs->Find(detail::ATTR_OPTIONAL)) )
+                 ! attrs || ! (attrs->Find(zeek::detail::ATTR_DEFAULT) || attrs->Find(zeek::detail::ATTR_OPTIONAL)) )
                 throw ParameterMismatch(hilti::rt::fmt("missing initialization for field '%s'", rtype->FieldName(idx)));
         }
     }
@@ -906,6 +944,9 @@ inline ValPtr to_val(const T& t, const TypePtr& target) {
 
     auto num_fields = rtype->NumFields();
 
+    auto& conversion_cache = detail::record_conversion_cache<T>();
+    bool check_names = ! conversion_cache.IsVerified(rtype.get());
+
     t.__visit([&](std::string_view name, const auto& val) {
         if ( idx >= num_fields )
             throw ParameterMismatch(hilti::rt::fmt("no matching record field for field '%s'", name));
@@ -930,12 +971,13 @@ inline ValPtr to_val(const T& t, const TypePtr& target) {
             reporter->InternalError("%s", msg.c_str());
         }
         else {
-            auto field = rtype->GetFieldType(idx);
-            std::string field_name = rtype->FieldName(idx);
+            if ( check_names ) {
+                std::string_view field_name = rtype->FieldName(idx);
 
-            if ( field_name != name )
-                throw ParameterMismatch(
-                    hilti::rt::fmt("mismatch in field name: expected '%s', found '%s'", name, field_name));
+                if ( field_name != name )
+                    throw ParameterMismatch(
+                        hilti::rt::fmt("mismatch in field name: expected '%s', found '%s'", name, field_name));
+            }
 
             set_record_field(rval.get(), rtype, idx++, val);
         }
@@ -946,6 +988,9 @@ inline ValPtr to_val(const T& t, const TypePtr& target) {
     if ( idx != num_fields )
         throw ParameterMismatch(hilti::rt::fmt("missing initialization for field '%s'", rtype->FieldName(idx + 1)));
 
+    if ( check_names )
+        conversion_cache.SetVerified(rtype);
+
     return rval;
 }
 
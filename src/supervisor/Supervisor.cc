@@ -6,6 +6,8 @@
 
 #include <fcntl.h>
 #include <poll.h>
+#include <sched.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -16,6 +18,10 @@
 #include <utility>
 #include <variant>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 #define RAPIDJSON_HAS_STDSTRING 1
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
@@ -38,6 +44,7 @@ extern "C" {
 #include "zeek/ZeekString.h"
 #include "zeek/input.h"
 #include "zeek/iosource/Manager.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/util.h"
 #include "zeek/zeek-affinity.h"
 
@@ -47,6 +54,12 @@ extern "C" {
 #define DBG_STEM(...)
 #endif
 
+// Zygotes need to fork node processes that become children of the Stem,
+// not of the zygote itself.
+#if defined(__linux__) && defined(SYS_clone) && defined(CLONE_PARENT)
+#define HAVE_ZYGOTE
+#endif
+
 using namespace zeek;
 using zeek::detail::SupervisedNode;
 using zeek::detail::SupervisorNode;
@@ -92,6 +105,24 @@ struct Stem {
      */
     std::variant<bool, SupervisedNode> Spawn(SupervisorNode* node);
 
+    /**
+     * Asks the node's zygote to fork a new node process.
+     * @return  true on success, false if the node has no usable zygote
+     * and needs to be spawned via Spawn() instead.
+     */
+    bool SpawnFromZygote(SupervisorNode* node) const;
+
+    /**
+     * Checks whether the node's zygote has reported its process ID.
+     * @param timeout_ms  how long to wait for the zygote to report in.
+     */
+    bool ZygoteReady(SupervisorNode* node, int timeout_ms) const;
+
+    /**
+     * Terminates the node's zygote, if it has one.
+     */
+    void DestroyZygote(SupervisorNode* node) const;
+
     int AliveNodeCount() const;
 
     void KillNodes(int signal);
@@ -408,6 +439,32 @@ static ForkResult fork_with_stdio_redirect(const char* where) {
     return {pid, std::move(out), std::move(err)};
 }
 
+#ifdef HAVE_ZYGOTE
+// Forks a process that becomes a child of the caller's parent rather than of
+// the caller itself, i.e. a sibling process.
+static pid_t fork_sibling() {
+    // Make sure buffered output doesn't get written by both processes.
+    fflush(stdout);
+    fflush(stderr);
+    return static_cast<pid_t>(syscall(SYS_clone, CLONE_PARENT | SIGCHLD, 0, 0, 0, 0));
+}
+#endif
+
+// Writes a process ID to a zygote socket.
+static bool send_pid(int fd, pid_t pid) {
+    return send(fd, &pid, sizeof(pid), MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(pid));
+}
+
+// Reads a process ID from a zygote socket, waiting at most the given time.
+static bool recv_pid(int fd, pid_t* pid, int timeout_ms) {
+    pollfd pfd = {fd, POLLIN, 0};
+
+    if ( poll(&pfd, 1, timeout_ms) <= 0 )
+        return false;
+
+    return recv(fd, pid, sizeof(*pid), MSG_DONTWAIT) == static_cast<ssize_t>(sizeof(*pid));
+}
+
 void Supervisor::HandleChildSignal() {
     if ( last_signal >= 0 ) {
         DBG_LOG(DBG_SUPERVISOR, "Supervisor received signal %d", last_signal);
@@ -716,8 +773,18 @@ bool Stem::Wait(SupervisorNode* node, int options) const {
         LogError("Stem failed to get node exit status '%s' (PID %d)", node->Name().data(), node->pid);
 
     node->pid = 0;
-    node->stdout_pipe.Drain();
-    node->stderr_pipe.Drain();
+
+    if ( ZygoteReady(node, 0) ) {
+        // The zygote holds on to the node's stdout/stderr, so keep the pipes
+        // open for the next node process it forks.
+        node->stdout_pipe.Process();
+        node->stderr_pipe.Process();
+    }
+    else {
+        node->stdout_pipe.Drain();
+        node->stderr_pipe.Drain();
+    }
+
     return true;
 }
 
@@ -798,6 +865,13 @@ std::optional<SupervisedNode> Stem::Revive() {
         if ( node.revival_attempts % attempts_before_delay_increase == 0 )
             node.revival_delay *= delay_increase_factor;
 
+        if ( SpawnFromZygote(&node) ) {
+            LogError("Supervised node '%s' (PID %d) revived from zygote after premature exit", node.Name().data(),
+                     node.pid);
+            ReportStatus(node);
+            continue;
+        }
+
         auto spawn_res = Spawn(&node);
 
         if ( std::holds_alternative<SupervisedNode>(spawn_res) )
@@ -813,12 +887,30 @@ std::optional<SupervisedNode> Stem::Revive() {
 }
 
 std::variant<bool, SupervisedNode> Stem::Spawn(SupervisorNode* node) {
+    // The new node process brings its own zygote.
+    DestroyZygote(node);
+
+    int zygote_fds[2] = {-1, -1};
+
+#ifdef HAVE_ZYGOTE
+    if ( node->config.zygote && socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, zygote_fds) == -1 ) {
+        LogError("failed to create zygote socket for node '%s': %s", node->Name().data(), strerror(errno));
+        zygote_fds[0] = zygote_fds[1] = -1;
+    }
+#endif
+
     auto ppid = getpid();
     auto fork_res = fork_with_stdio_redirect(util::fmt("node %s", node->Name().data()));
     auto node_pid = fork_res.pid;
 
     if ( node_pid == -1 ) {
         LogError("failed to fork Zeek node '%s': %s", node->Name().data(), strerror(errno));
+
+        if ( zygote_fds[0] >= 0 ) {
+            close(zygote_fds[0]);
+            close(zygote_fds[1]);
+        }
+
         return false;
     }
 
@@ -826,12 +918,27 @@ std::variant<bool, SupervisedNode> Stem::Spawn(SupervisorNode* node) {
         setsignal(SIGCHLD, SIG_DFL);
         setsignal(SIGTERM, SIG_DFL);
         util::detail::set_thread_name(util::fmt("zeek.%s", node->Name().data()));
+
+        for ( const auto& [_, n] : nodes )
+            if ( n.zygote_fd >= 0 )
+                close(n.zygote_fd);
+
+        if ( zygote_fds[0] >= 0 )
+            close(zygote_fds[0]);
+
         SupervisedNode rval;
         rval.config = node->config;
         rval.parent_pid = ppid;
+        rval.zygote_fd = zygote_fds[1];
+        rval.spawn_time = util::current_time();
         return rval;
     }
 
+    if ( zygote_fds[0] >= 0 ) {
+        close(zygote_fds[1]);
+        node->zygote_fd = zygote_fds[0];
+    }
+
     node->pid = node_pid;
     auto prefix = util::fmt("[%s] ", node->Name().data());
     node->stdout_pipe.pipe = std::move(fork_res.stdout_pipe);
@@ -845,6 +952,89 @@ std::variant<bool, SupervisedNode> Stem::Spawn(SupervisorNode* node) {
     return true;
 }
 
+bool Stem::SpawnFromZygote(SupervisorNode* node) const {
+    if ( ! ZygoteReady(node, 0) )
+        return false;
+
+    // Without the output pipes, there's nothing to read the new process'
+    // output from.
+    if ( node->stdout_pipe.pipe && node->stderr_pipe.pipe ) {
+        constexpr auto reply_timeout_ms = 5000;
+        char cmd = 's';
+        pid_t node_pid = -1;
+
+        if ( send(node->zygote_fd, &cmd, 1, MSG_NOSIGNAL) == 1 &&
+             recv_pid(node->zygote_fd, &node_pid, reply_timeout_ms) && node_pid > 0 ) {
+            node->pid = node_pid;
+            node->spawn_time = std::chrono::steady_clock::now();
+            DBG_STEM("Stem spawned node from zygote: %s (PID %d)", node->Name().data(), node->pid);
+            return true;
+        }
+    }
+
+    LogError("failed to spawn node '%s' from its zygote (PID %d), starting it from scratch", node->Name().data(),
+             node->zygote_pid);
+    DestroyZygote(node);
+    return false;
+}
+
+bool Stem::ZygoteReady(SupervisorNode* node, int timeout_ms) const {
+    if ( node->zygote_pid > 0 )
+        return true;
+
+    if ( node->zygote_fd < 0 )
+        return false;
+
+    // The zygote reports its process ID once right after getting forked.
+    pid_t zygote_pid = 0;
+
+    if ( ! recv_pid(node->zygote_fd, &zygote_pid, timeout_ms) || zygote_pid <= 0 )
+        return false;
+
+    node->zygote_pid = zygote_pid;
+    DBG_STEM("Stem got zygote for node: %s (PID %d)", node->Name().data(), node->zygote_pid);
+    return true;
+}
+
+void Stem::DestroyZygote(SupervisorNode* node) const {
+    if ( node->zygote_fd < 0 )
+        return;
+
+    // A zygote forked right before the node process exited may not have
+    // reported in yet, give it a moment to do so.
+    constexpr auto ready_timeout_ms = 1000;
+    ZygoteReady(node, ready_timeout_ms);
+
+    if ( node->zygote_pid > 0 ) {
+        DBG_STEM("Stem destroying zygote of node: %s (PID %d)", node->Name().data(), node->zygote_pid);
+        kill(node->zygote_pid, SIGKILL);
+
+        while ( waitpid(node->zygote_pid, nullptr, 0) == -1 && errno == EINTR )
+            ;
+
+        node->zygote_pid = 0;
+
+        // With the zygote gone, the socket holds the IDs of all node
+        // processes it reported after SpawnFromZygote() stopped waiting.
+        // Nothing tracks those, so don't let them run.
+        pid_t orphan_pid = 0;
+
+        while ( recv_pid(node->zygote_fd, &orphan_pid, 0) ) {
+            if ( orphan_pid <= 0 )
+                continue;
+
+            LogError("killing node '%s' (PID %d) that its zygote forked too late", node->Name().data(), orphan_pid);
+            kill(orphan_pid, SIGKILL);
+
+            while ( waitpid(orphan_pid, nullptr, 0) == -1 && errno == EINTR )
+                ;
+        }
+    }
+
+    close(node->zygote_fd);
+    node->zygote_fd = -1;
+}
+
 int Stem::AliveNodeCount() const {
     auto rval = 0;
 
@@ -880,6 +1070,9 @@ void Stem::Shutdown(int exit_code) {
         auto nodes_alive = AliveNodeCount();
 
         if ( nodes_alive == 0 ) {
+            for ( auto& [_, node] : nodes )
+                DestroyZygote(&node);
+
             exit(exit_code);
         }
 
@@ -895,8 +1088,12 @@ void Stem::Shutdown(int exit_code) {
                 Reap();
                 nodes_alive = AliveNodeCount();
 
-                if ( nodes_alive == 0 )
+                if ( nodes_alive == 0 ) {
+                    for ( auto& [_, node] : nodes )
+                        DestroyZygote(&node);
+
                     exit(exit_code);
+                }
             }
         }
     }
@@ -1084,6 +1281,7 @@ std::optional<SupervisedNode> Stem::Poll() {
             auto& node = it->second;
             DBG_STEM("Stem destroying node: %s (PID %d)", node_name.data(), node.pid);
             Destroy(&node);
+            DestroyZygote(&node);
             nodes.erase(it);
         }
         else if ( cmd == "restart" ) {
@@ -1093,6 +1291,9 @@ std::optional<SupervisedNode> Stem::Poll() {
             DBG_STEM("Stem restarting node: %s (PID %d)", node_name.data(), node.pid);
             Destroy(&node);
 
+            // A restart is expected to pick up changed scripts, which the
+            // zygote has parsed already. Spawn() replaces the zygote along
+            // with the node.
             auto spawn_res = Spawn(&node);
 
             if ( std::holds_alternative<SupervisedNode>(spawn_res) )
@@ -1219,6 +1420,8 @@ Supervisor::NodeConfig Supervisor::NodeConfig::FromRecord(const RecordVal* node)
     if ( bare_mode_val )
         rval.bare_mode = bare_mode_val->AsBool();
 
+    rval.zygote = node->GetFieldOrDefault("zygote")->AsBool();
+
     auto addl_base_scripts_val = node->GetField("addl_base_scripts")->AsVectorVal();
 
     for ( auto i = 0u; i < addl_base_scripts_val->Size(); ++i ) {
@@ -1279,6 +1482,9 @@ Supervisor::NodeConfig Supervisor::NodeConfig::FromJSON(std::string_view json) {
     if ( auto it = j.FindMember("bare_mode"); it != j.MemberEnd() )
         rval.bare_mode = it->value.GetBool();
 
+    if ( auto it = j.FindMember("zygote"); it != j.MemberEnd() )
+        rval.zygote = it->value.GetBool();
+
     auto& addl_base_scripts = j["addl_base_scripts"];
 
     for ( auto it = addl_base_scripts.Begin(); it != addl_base_scripts.End(); ++it )
@@ -1335,6 +1541,8 @@ RecordValPtr Supervisor::NodeConfig::ToRecord() const {
     if ( bare_mode )
         rval->AssignField("bare_mode", *bare_mode);
 
+    rval->AssignField("zygote", zygote);
+
     auto abs_t = rt->GetFieldType<VectorType>("addl_base_scripts");
     auto addl_base_scripts_val = make_intrusive<VectorVal>(std::move(abs_t));
 
@@ -1466,6 +1674,133 @@ void SupervisedNode::Init(Options* options) const {
     stl.insert(stl.end(), config.addl_user_scripts.begin(), config.addl_user_scripts.end());
 }
 
+#ifdef HAVE_ZYGOTE
+// The zygote's main loop: forks a node process whenever the Stem asks for
+// one. Only returns in those node processes.
+static void run_zygote(SupervisedNode* node) {
+    util::detail::set_thread_name(util::fmt("zeek.zygote.%s", node->config.name.data()));
+    auto fd = node->zygote_fd;
+
+    if ( ! send_pid(fd, getpid()) )
+        _exit(1);
+
+    for ( ;; ) {
+        pollfd pfd = {fd, POLLIN, 0};
+        auto res = poll(&pfd, 1, 1000);
+
+        // Same parent check as the Stem's, see Stem::Poll().
+        if ( getppid() != node->parent_pid )
+            _exit(0);
+
+        if ( res <= 0 )
+            continue;
+
+        char cmd;
+        auto n = read(fd, &cmd, 1);
+
+        if ( n < 0 && (errno == EINTR || errno == EAGAIN) )
+            continue;
+
+        if ( n <= 0 )
+            // The Stem closed the socket, it doesn't need us anymore.
+            _exit(0);
+
+        // The new node process waits for the go-ahead on this pipe, which
+        // the zygote only gives once it has reported the process to the
+        // Stem. Should the zygote die in between, the node process exits
+        // rather than running without the Stem knowing about it.
+        int go_fds[2];
+
+        if ( pipe(go_fds) == -1 ) {
+            if ( ! send_pid(fd, -1) )
+                _exit(1);
+
+            continue;
+        }
+
+        auto pid = fork_sibling();
+
+        if ( pid == 0 ) {
+            close(go_fds[1]);
+
+            char go;
+            ssize_t go_n;
+
+            while ( (go_n = read(go_fds[0], &go, 1)) == -1 && errno == EINTR )
+                ;
+
+            if ( go_n != 1 )
+                _exit(1);
+
+            close(go_fds[0]);
+            close(fd);
+            node->zygote_fd = -1;
+            node->from_zygote = true;
+            node->spawn_time = util::current_time();
+            util::detail::set_thread_name(util::fmt("zeek.%s", node->config.name.data()));
+            return;
+        }
+
+        close(go_fds[0]);
+
+        // Reports -1 on failure, which makes the Stem fall back to
+        // spawning the node from scratch.
+        if ( ! send_pid(fd, pid) )
+            _exit(1);
+
+        if ( pid > 0 )
+            while ( write(go_fds[1], "g", 1) == -1 && errno == EINTR )
+                ;
+
+        close(go_fds[1]);
+    }
+}
+#endif
+
+void Supervisor::StartZygote() {
+    if ( ! supervised_node || supervised_node->zygote_fd < 0 )
+        return;
+
+    auto& node = *supervised_node;
+
+#ifdef HAVE_ZYGOTE
+    auto pid = fork_sibling();
+
+    if ( pid == -1 )
+        fprintf(stderr, "node '%s' failed to fork its zygote: %s\n", node.config.name.data(), strerror(errno));
+
+    if ( pid == 0 ) {
+        run_zygote(&node);
+
+        // This is a new node process now. It must not share the kqueue
+        // with the node process the zygote was forked from, nor generate
+        // the same random numbers.
+        iosource_mgr->RecreateEventQueue();
+
+        if ( ! util::detail::have_random_seed() )
+            util::detail::seed_random(static_cast<unsigned int>(getpid()) ^ static_cast<unsigned int>(time(nullptr)));
+    }
+#endif
+
+    if ( node.zygote_fd >= 0 ) {
+        close(node.zygote_fd);
+        node.zygote_fd = -1;
+    }
+}
+
+void SupervisedNode::ObserveFirstPacket() const {
+    auto latency = util::current_time() - spawn_time;
+    DBG_LOG(DBG_SUPERVISOR, "node '%s' processed its first packet %.3f seconds after being forked from the %s",
+            config.name.data(), latency, from_zygote ? "zygote" : "stem");
+
+    auto gauge = telemetry_mgr->GaugeInstance("zeek", "supervised_node_first_packet_latency",
+                                              {{"spawn", from_zygote ? "zygote" : "stem"}},
+                                              "Time from forking a supervised node process until it processed its "
+                                              "first packet",
+                                              "seconds");
+    gauge->Set(latency);
+}
+
 RecordValPtr Supervisor::Status(std::string_view node_name) {
     auto rval = make_intrusive<RecordVal>(BifType::Record::Supervisor::Status);
     const auto& tt = BifType::Record::Supervisor::Status->GetFieldType("nodes");
@@ -193,6 +193,11 @@ public:
          * node inherits the bare-mode status of the supervisor.
          */
         std::optional<bool> bare_mode;
+        /**
+         * Whether to keep a zygote process for the node that revived node
+         * processes get forked from.
+         */
+        bool zygote = false;
         /**
          * Additional script filenames/paths that the node should load
          * after the base scripts, and prior to any user-specified ones.
@@ -234,6 +239,15 @@ public:
      */
     static const std::optional<detail::SupervisedNode>& ThisNode() { return supervised_node; }
 
+    /**
+     * Forks the zygote process of a supervised node that runs in zygote
+     * mode, otherwise does nothing.  Must be called by the node once its
+     * scripts are loaded, but before any threads get started.  The zygote
+     * never returns from this function, but each node process that it later
+     * forks on behalf of the Stem does, and continues from there.
+     */
+    static void StartZygote();
+
     using NodeMap = std::map<std::string, detail::SupervisorNode, std::less<>>;
 
     /**
@@ -389,11 +403,30 @@ struct SupervisedNode {
      * The node's configuration options.
      */
     Supervisor::NodeConfig config;
+    /**
+     * Records metrics on the time it took from spawning the node to
+     * processing its first packet.
+     */
+    void ObserveFirstPacket() const;
+
     /**
      * The process ID of the supervised node's parent process (i.e. the PID
      * of the Stem process).
      */
     pid_t parent_pid;
+    /**
+     * The node's end of the socket connecting its zygote with the Stem, or
+     * -1 if there is none.
+     */
+    int zygote_fd = -1;
+    /**
+     * Whether the node process was forked from the zygote.
+     */
+    bool from_zygote = false;
+    /**
+     * The wall-clock time at which the node process was forked.
+     */
+    double spawn_time = 0.0;
 };
 
 /**
@@ -461,6 +494,15 @@ struct SupervisorNode {
      * any output written to the Node's stdout.
      */
     detail::LineBufferedPipe stderr_pipe;
+    /**
+     * The Stem's end of the socket connecting it with the node's zygote,
+     * or -1 if the node doesn't run in zygote mode.
+     */
+    int zygote_fd = -1;
+    /**
+     * Process ID of the node's zygote, or zero if it hasn't reported in yet.
+     */
+    pid_t zygote_pid = 0;
 };
 
 /**
@@ -12,6 +12,25 @@ double Counter::Value() const noexcept {
     return handle.Value();
 }
 
+uint64_t ShardedCounter::Value() const noexcept {
+    uint64_t sum = 0;
+
+    for ( const auto& shard : shards )
+        sum += shard.value.load(std::memory_order_relaxed);
+
+    return sum;
+}
+
+void ShardedCounter::Flush() {
+    auto total = Value();
+
+    if ( total == flushed )
+        return;
+
+    counter->Inc(static_cast<double>(total - flushed));
+    flushed = total;
+}
+
 std::shared_ptr<Counter> CounterFamily::GetOrAdd(Span<const LabelView> labels, detail::CollectCallbackPtr callback) {
     prometheus::Labels p_labels = detail::BuildPrometheusLabels(labels);
 
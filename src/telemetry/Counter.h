@@ -4,6 +4,9 @@
 
 #include <prometheus/counter.h>
 #include <prometheus/family.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
 
@@ -79,6 +82,55 @@ private:
 
 using CounterPtr = std::shared_ptr<Counter>;
 
+/**
+ * A counter for hot code paths. Each thread accumulates integral increments
+ * in a shard of its own, without any atomic read-modify-write operations.
+ * The shards only get summed up and added to the underlying counter when
+ * metrics are collected, so the exported value lags behind until then.
+ */
+class ShardedCounter final : public detail::ShardedMetric {
+public:
+    explicit ShardedCounter(CounterPtr counter) noexcept : counter(std::move(counter)) {}
+
+    /**
+     * Increments the value by @p amount.
+     */
+    void Inc(uint64_t amount = 1) noexcept {
+        if ( auto slot = detail::ThreadSlot(); slot < detail::NUM_EXCLUSIVE_SHARDS ) {
+            // Only this thread ever writes the shard, so a plain load and
+            // store suffice. The atomics just make the reads in Flush() safe.
+            auto& value = shards[slot].value;
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+        else
+            shards[detail::NUM_EXCLUSIVE_SHARDS].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return The sum of all increments, including the ones not yet flushed
+     * to the underlying counter.
+     */
+    uint64_t Value() const noexcept;
+
+    /**
+     * @return The underlying counter.
+     */
+    const CounterPtr& Underlying() const noexcept { return counter; }
+
+    void Flush() override;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    std::array<Shard, detail::NUM_EXCLUSIVE_SHARDS + 1> shards;
+    uint64_t flushed = 0;
+    CounterPtr counter;
+};
+
+using ShardedCounterPtr = std::shared_ptr<ShardedCounter>;
+
 class CounterFamily : public MetricFamily {
 public:
     static inline const char* OpaqueName = "CounterMetricFamilyVal";
@@ -1,5 +1,7 @@
 #include "zeek/telemetry/Histogram.h"
 
+#include <algorithm>
+
 using namespace zeek::telemetry;
 
 double Histogram::Sum() const noexcept {
@@ -11,6 +13,66 @@ Histogram::Histogram(FamilyType* family, const prometheus::Labels& labels,
                      prometheus::Histogram::BucketBoundaries bounds) noexcept
     : handle(family->Add(labels, std::move(bounds))), labels(labels) {}
 
+ShardedHistogram::ShardedHistogram(HistogramPtr histogram, Span<const double> arg_bounds)
+    : bounds(arg_bounds.begin(), arg_bounds.end()),
+      flushed_buckets(bounds.size() + 1),
+      histogram(std::move(histogram)) {
+    size_t num_lines = (bounds.size() + BucketLine::Size) / BucketLine::Size;
+
+    for ( auto& shard : shards ) {
+        shard.lines = std::make_unique<BucketLine[]>(num_lines);
+        for ( size_t i = 0; i <= bounds.size(); i++ )
+            shard.Bucket(i).store(0, std::memory_order_relaxed);
+    }
+}
+
+void ShardedHistogram::Observe(double value) noexcept {
+    // Same bucket selection as prometheus::Histogram::Observe().
+    size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+
+    if ( auto slot = detail::ThreadSlot(); slot < detail::NUM_EXCLUSIVE_SHARDS ) {
+        auto& shard = shards[slot];
+        auto& count = shard.Bucket(bucket);
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        shard.sum.store(shard.sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    else {
+        auto& shard = shards[detail::NUM_EXCLUSIVE_SHARDS];
+        shard.Bucket(bucket).fetch_add(1, std::memory_order_relaxed);
+
+        auto sum = shard.sum.load(std::memory_order_relaxed);
+        while ( ! shard.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed) )
+            ;
+    }
+}
+
+void ShardedHistogram::Flush() {
+    std::vector<double> increments(bounds.size() + 1);
+    bool changed = false;
+
+    for ( size_t i = 0; i <= bounds.size(); i++ ) {
+        uint64_t total = 0;
+        for ( const auto& shard : shards )
+            total += shard.Bucket(i).load(std::memory_order_relaxed);
+
+        if ( total != flushed_buckets[i] ) {
+            increments[i] = static_cast<double>(total - flushed_buckets[i]);
+            flushed_buckets[i] = total;
+            changed = true;
+        }
+    }
+
+    if ( ! changed )
+        return;
+
+    double sum = 0.0;
+    for ( const auto& shard : shards )
+        sum += shard.sum.load(std::memory_order_relaxed);
+
+    histogram->ObserveMultiple(increments, sum - flushed_sum);
+    flushed_sum = sum;
+}
+
 std::shared_ptr<Histogram> HistogramFamily::GetOrAdd(Span<const LabelView> labels) {
     prometheus::Labels p_labels = detail::BuildPrometheusLabels(labels);
 
@@ -4,9 +4,12 @@
 
 #include <prometheus/family.h>
 #include <prometheus/histogram.h>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <initializer_list>
 #include <memory>
+#include <vector>
 
 #include "zeek/NetVar.h"
 #include "zeek/Span.h"
@@ -31,6 +34,16 @@ public:
      */
     void Observe(double value) noexcept { handle.Observe(value); }
 
+    /**
+     * Adds @p bucket_increments to the buckets and @p sum to the total sum
+     * of all observed values, as if the corresponding values had been
+     * observed individually.
+     * @pre `bucket_increments` has one entry per bucket, including +Inf.
+     */
+    void ObserveMultiple(const std::vector<double>& bucket_increments, double sum) {
+        handle.ObserveMultiple(bucket_increments, sum);
+    }
+
     /// @return The sum of all observed values.
     double Sum() const noexcept;
 
@@ -46,6 +59,62 @@ private:
 
 using HistogramPtr = std::shared_ptr<Histogram>;
 
+/**
+ * A histogram for hot code paths. Like ShardedCounter, each thread records
+ * observations in a shard of its own and the shards only get added to the
+ * underlying histogram when metrics are collected.
+ */
+class ShardedHistogram final : public detail::ShardedMetric {
+public:
+    /**
+     * Constructor. @p bounds must match the bucket boundaries of the
+     * underlying histogram.
+     */
+    ShardedHistogram(HistogramPtr histogram, Span<const double> bounds);
+
+    /**
+     * Records an observation of @p value.
+     */
+    void Observe(double value) noexcept;
+
+    /**
+     * @return The underlying histogram.
+     */
+    const HistogramPtr& Underlying() const noexcept { return histogram; }
+
+    void Flush() override;
+
+private:
+    // Bucket counts come in whole cache lines, so that the separately
+    // allocated counts of different shards never share one.
+    struct alignas(64) BucketLine {
+        static constexpr size_t Size = 64 / sizeof(std::atomic<uint64_t>);
+        std::atomic<uint64_t> counts[Size];
+    };
+
+    struct alignas(64) Shard {
+        // One entry per bucket, the last one for +Inf.
+        std::unique_ptr<BucketLine[]> lines;
+        std::atomic<double> sum = 0.0;
+
+        std::atomic<uint64_t>& Bucket(size_t i) noexcept {
+            return lines[i / BucketLine::Size].counts[i % BucketLine::Size];
+        }
+
+        const std::atomic<uint64_t>& Bucket(size_t i) const noexcept {
+            return lines[i / BucketLine::Size].counts[i % BucketLine::Size];
+        }
+    };
+
+    std::vector<double> bounds;
+    std::array<Shard, detail::NUM_EXCLUSIVE_SHARDS + 1> shards;
+    std::vector<uint64_t> flushed_buckets;
+    double flushed_sum = 0.0;
+    HistogramPtr histogram;
+};
+
+using ShardedHistogramPtr = std::shared_ptr<ShardedHistogram>;
+
 class HistogramFamily : public MetricFamily {
 public:
     static inline const char* OpaqueName = "HistogramMetricFamilyVal";
@@ -12,6 +12,7 @@
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <algorithm>
+#include <chrono>
 #include <thread>
 
 #include "zeek/3rdparty/doctest.h"
@@ -289,6 +290,7 @@ ValPtr Manager::CollectMetrics(std::string_view prefix_pattern, std::string_view
     static auto metric_opts_type = zeek::id::find_type<zeek::RecordType>("Telemetry::MetricOpts");
     static auto metric_type_idx = metric_opts_type->FieldOffset("metric_type");
 
+    FlushShardedMetrics();
     InvokeTelemetrySyncHook();
 
     VectorValPtr ret_val = make_intrusive<VectorVal>(metrics_vector_type);
@@ -368,6 +370,7 @@ ValPtr Manager::CollectHistogramMetrics(std::string_view prefix_pattern, std::st
     static auto metric_opts_type = zeek::id::find_type<zeek::RecordType>("Telemetry::MetricOpts");
     static auto metric_type_idx = metric_opts_type->FieldOffset("metric_type");
 
+    FlushShardedMetrics();
     InvokeTelemetrySyncHook();
 
     VectorValPtr ret_val = make_intrusive<VectorVal>(metrics_vector_type);
@@ -591,11 +594,59 @@ HistogramPtr Manager::HistogramInstance(std::string_view prefix, std::string_vie
     return HistogramInstance(prefix, name, lbls, bounds_span, helptext, unit);
 }
 
+ShardedCounterPtr Manager::ShardedCounterInstance(std::string_view prefix, std::string_view name,
+                                                  Span<const LabelView> labels, std::string_view helptext,
+                                                  std::string_view unit) {
+    auto counter = std::make_shared<ShardedCounter>(CounterInstance(prefix, name, labels, helptext, unit));
+    sharded_metrics.emplace_back(counter);
+    return counter;
+}
+
+ShardedCounterPtr Manager::ShardedCounterInstance(std::string_view prefix, std::string_view name,
+                                                  std::initializer_list<LabelView> labels, std::string_view helptext,
+                                                  std::string_view unit) {
+    auto lbl_span = Span{labels.begin(), labels.size()};
+    return ShardedCounterInstance(prefix, name, lbl_span, helptext, unit);
+}
+
+ShardedHistogramPtr Manager::ShardedHistogramInstance(std::string_view prefix, std::string_view name,
+                                                      Span<const LabelView> labels, ConstSpan<double> bounds,
+                                                      std::string_view helptext, std::string_view unit) {
+    auto histogram = std::make_shared<ShardedHistogram>(HistogramInstance(prefix, name, labels, bounds, helptext, unit),
+                                                        bounds);
+    sharded_metrics.emplace_back(histogram);
+    return histogram;
+}
+
+ShardedHistogramPtr Manager::ShardedHistogramInstance(std::string_view prefix, std::string_view name,
+                                                      std::initializer_list<LabelView> labels,
+                                                      std::initializer_list<double> bounds, std::string_view helptext,
+                                                      std::string_view unit) {
+    auto lbls = Span{labels.begin(), labels.size()};
+    auto bounds_span = Span{bounds.begin(), bounds.size()};
+    return ShardedHistogramInstance(prefix, name, lbls, bounds_span, helptext, unit);
+}
+
+void Manager::FlushShardedMetrics() {
+    auto it = sharded_metrics.begin();
+
+    while ( it != sharded_metrics.end() ) {
+        if ( auto m = it->lock() ) {
+            m->Flush();
+            ++it;
+        }
+        else
+            it = sharded_metrics.erase(it);
+    }
+}
+
 void Manager::ProcessFd(int fd, int flags) {
     std::unique_lock<std::mutex> lk(collector_cv_mtx);
 
     collector_flare.Extinguish();
 
+    FlushShardedMetrics();
+
     for ( const auto& [name, f] : families )
         f->RunCallbacks();
 
@@ -741,3 +792,85 @@ SCENARIO("telemetry managers provide access to histogram families") {
         }
     }
 }
+
+SCENARIO("sharded metrics aggregate per-thread updates when flushed") {
+    GIVEN("a telemetry manager") {
+        Manager mgr;
+        WHEN("incrementing a sharded counter from several threads") {
+            auto counter = mgr.ShardedCounterInstance("zeek", "sharded-requests", {}, "test");
+            std::vector<std::thread> threads;
+            for ( int i = 0; i < 20; i++ )
+                threads.emplace_back([&counter]() {
+                    for ( int j = 0; j < 1000; j++ )
+                        counter->Inc();
+                });
+
+            for ( auto& t : threads )
+                t.join();
+
+            THEN("the underlying counter only changes on flush") {
+                CHECK_EQ(counter->Value(), 20000u);
+                CHECK_EQ(counter->Underlying()->Value(), 0.0);
+                counter->Flush();
+                CHECK_EQ(counter->Underlying()->Value(), 20000.0);
+                counter->Inc(5);
+                counter->Flush();
+                counter->Flush();
+                CHECK_EQ(counter->Underlying()->Value(), 20005.0);
+            }
+        }
+        WHEN("observing values with a sharded histogram") {
+            auto histogram =
+                mgr.ShardedHistogramInstance("zeek", "sharded-latency", {}, {1.0, 10.0}, "test", "seconds");
+            histogram->Observe(0.5);
+            histogram->Observe(1.0);
+            std::thread t([&histogram]() { histogram->Observe(20.0); });
+            t.join();
+
+            THEN("the underlying histogram only changes on flush") {
+                CHECK_EQ(histogram->Underlying()->Sum(), 0.0);
+                histogram->Flush();
+                CHECK_EQ(histogram->Underlying()->Sum(), 21.5);
+                histogram->Flush();
+                CHECK_EQ(histogram->Underlying()->Sum(), 21.5);
+            }
+        }
+    }
+}
+
+// Compares plain and sharded counters in a tight loop. Skipped by default,
+// run with: zeek --test --test-case="*sharded counter benchmark*" --no-skip
+TEST_CASE("telemetry sharded counter benchmark" * doctest::skip(true)) {
+    constexpr int iterations = 10000000;
+    constexpr int num_threads = 4;
+
+    Manager mgr;
+    auto plain = mgr.CounterInstance("zeek", "bench-plain", {}, "test");
+    auto sharded = mgr.ShardedCounterInstance("zeek", "bench-sharded", {}, "test");
+
+    auto run = [](int threads, auto&& inc) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> ts;
+        for ( int i = 0; i < threads; i++ )
+            ts.emplace_back([&inc]() {
+                for ( int j = 0; j < iterations; j++ )
+                    inc();
+            });
+
+        for ( auto& t : ts )
+            t.join();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() * 1e9 / iterations;
+    };
+
+    for ( int threads : {1, num_threads} ) {
+        auto plain_ns = run(threads, [&plain]() { plain->Inc(); });
+        auto sharded_ns = run(threads, [&sharded]() { sharded->Inc(); });
+        MESSAGE(threads << " thread(s): Counter::Inc " << plain_ns << " ns/iteration, ShardedCounter::Inc "
+                        << sharded_ns << " ns/iteration");
+    }
+
+    sharded->Flush();
+    CHECK_EQ(sharded->Underlying()->Value(), plain->Value());
+}
@@ -109,6 +109,25 @@ public:
                                std::string_view helptext, std::string_view unit = "",
                                detail::CollectCallbackPtr callback = nullptr);
 
+    /**
+     * Like CounterInstance(), but returns a counter that accumulates
+     * increments per thread and only adds them to the exported counter when
+     * metrics get collected. Use this for counters updated on hot paths.
+     * @param prefix The prefix (namespace) this family belongs to.
+     * @param name The human-readable name of the metric, e.g., `requests`.
+     * @param labels Values for all label dimensions of the metric.
+     * @param helptext Short explanation of the metric.
+     * @param unit Unit of measurement.
+     */
+    ShardedCounterPtr ShardedCounterInstance(std::string_view prefix, std::string_view name,
+                                             Span<const LabelView> labels, std::string_view helptext,
+                                             std::string_view unit = "");
+
+    /// @copydoc ShardedCounterInstance
+    ShardedCounterPtr ShardedCounterInstance(std::string_view prefix, std::string_view name,
+                                             std::initializer_list<LabelView> labels, std::string_view helptext,
+                                             std::string_view unit = "");
+
     /**
      * @return A gauge metric family. Creates the family lazily if necessary.
      * @param prefix The prefix (namespace) this family belongs to.
@@ -208,6 +227,28 @@ public:
                                    std::initializer_list<LabelView> labels, std::initializer_list<double> bounds,
                                    std::string_view helptext, std::string_view unit = "");
 
+    /**
+     * Like HistogramInstance(), but returns a histogram that records
+     * observations per thread and only adds them to the exported histogram
+     * when metrics get collected. Use this for histograms updated on hot
+     * paths.
+     * @param prefix The prefix (namespace) this family belongs to.
+     * @param name The human-readable name of the metric, e.g., `latency`.
+     * @param labels Values for all label dimensions of the metric.
+     * @param bounds Upper bounds for the metric buckets.
+     * @param helptext Short explanation of the metric.
+     * @param unit Unit of measurement.
+     */
+    ShardedHistogramPtr ShardedHistogramInstance(std::string_view prefix, std::string_view name,
+                                                 Span<const LabelView> labels, ConstSpan<double> bounds,
+                                                 std::string_view helptext, std::string_view unit = "");
+
+    /// @copydoc ShardedHistogramInstance
+    ShardedHistogramPtr ShardedHistogramInstance(std::string_view prefix, std::string_view name,
+                                                 std::initializer_list<LabelView> labels,
+                                                 std::initializer_list<double> bounds, std::string_view helptext,
+                                                 std::string_view unit = "");
+
     /**
      * @return A JSON description of the cluster configuration for reporting
      * to Prometheus for service discovery requests.
@@ -264,10 +305,17 @@ private:
      */
     void InvokeTelemetrySyncHook();
 
+    /**
+     * Adds the values accumulated by all sharded metrics to their underlying
+     * metrics.
+     */
+    void FlushShardedMetrics();
+
     bool in_sync_hook = false;
 
     std::map<std::string, std::shared_ptr<MetricFamily>> families;
     std::map<std::string, RecordValPtr> opts_records;
+    std::vector<std::weak_ptr<detail::ShardedMetric>> sharded_metrics;
 
     detail::process_stats current_process_stats;
     double process_stats_last_updated = 0.0;
@@ -1,5 +1,7 @@
 #include "Utils.h"
 
+#include <thread>
+
 #include "zeek/ID.h"
 #include "zeek/Reporter.h"
 #include "zeek/Val.h"
@@ -9,6 +11,44 @@ using namespace zeek;
 
 namespace zeek::telemetry::detail {
 
+// Static initialization runs on the main thread.
+static const std::thread::id main_thread_id = std::this_thread::get_id();
+
+// Bit i is set while slot i is taken. Slot 0 always belongs to the main thread.
+static std::atomic<uint32_t> taken_slots = 1;
+
+static_assert(NUM_EXCLUSIVE_SHARDS <= 32);
+
+size_t AcquireThreadSlot() noexcept {
+    if ( std::this_thread::get_id() == main_thread_id )
+        return 0;
+
+    auto taken = taken_slots.load(std::memory_order_relaxed);
+
+    while ( true ) {
+        size_t slot = 1;
+
+        while ( slot < NUM_EXCLUSIVE_SHARDS && (taken & (1u << slot)) )
+            ++slot;
+
+        if ( slot == NUM_EXCLUSIVE_SHARDS )
+            return slot;
+
+        // Acquire pairs with the release of the slot's previous owner, whose
+        // updates to the shards the new owner continues from.
+        if ( taken_slots.compare_exchange_weak(taken, taken | (1u << slot), std::memory_order_acquire,
+                                               std::memory_order_relaxed) )
+            return slot;
+    }
+}
+
+void ReleaseThreadSlot(size_t slot) noexcept {
+    if ( slot == 0 || slot >= NUM_EXCLUSIVE_SHARDS )
+        return;
+
+    taken_slots.fetch_and(~(1u << slot), std::memory_order_release);
+}
+
 std::string BuildFullPrometheusName(std::string_view prefix, std::string_view name, std::string_view unit,
                                     bool is_sum) {
     if ( prefix.empty() || name.empty() )
@@ -2,6 +2,8 @@
 
 #include <prometheus/family.h>
 #include <prometheus/labels.h>
+#include <atomic>
+#include <cstddef>
 #include <string_view>
 
 #include "zeek/Span.h"
@@ -24,5 +26,56 @@ prometheus::Labels BuildPrometheusLabels(Span<const LabelView> labels);
 std::string BuildFullPrometheusName(std::string_view prefix, std::string_view name, std::string_view unit,
                                     bool is_sum = false);
 
+/**
+ * Number of shards of sharded metrics that are owned by a single thread.
+ * Threads beyond that share one additional shard.
+ */
+constexpr size_t NUM_EXCLUSIVE_SHARDS = 15;
+
+/**
+ * Claims the lowest free slot for the calling thread. Slot 0 is reserved
+ * for the main thread.
+ * @return The slot, or NUM_EXCLUSIVE_SHARDS if all are taken.
+ */
+size_t AcquireThreadSlot() noexcept;
+
+/**
+ * Returns a slot claimed with AcquireThreadSlot() for reuse by other threads.
+ */
+void ReleaseThreadSlot(size_t slot) noexcept;
+
+/**
+ * Holds a thread's slot for as long as the thread lives.
+ */
+struct ThreadSlotHolder {
+    size_t slot = AcquireThreadSlot();
+    ~ThreadSlotHolder() { ReleaseThreadSlot(slot); }
+};
+
+/**
+ * @return A small number identifying the calling thread among the running
+ * ones, always 0 for the main thread. Once a thread exits, its number goes
+ * to the next new thread.
+ */
+inline size_t ThreadSlot() noexcept {
+    thread_local ThreadSlotHolder holder;
+    return holder.slot;
+}
+
+/**
+ * Base class for metrics that accumulate updates locally and only pass them
+ * on to the underlying prometheus metric when metrics get collected.
+ */
+class ShardedMetric {
+public:
+    virtual ~ShardedMetric() = default;
+
+    /**
+     * Adds all updates since the last call to the underlying metric. Called
+     * by the telemetry manager on the main thread.
+     */
+    virtual void Flush() = 0;
+};
+
 } // namespace detail
 } // namespace zeek::telemetry
@@ -4,6 +4,9 @@
 
 #include <pthread.h>
 #include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 
 #include "zeek/threading/Manager.h"
 #include "zeek/util.h"
@@ -16,6 +19,7 @@ uint64_t BasicThread::thread_counter = 0;
 
 BasicThread::BasicThread() {
     started = false;
+    pooled = false;
     terminating = false;
     killed = false;
 
@@ -43,36 +47,63 @@ void BasicThread::SetName(const char* arg_name) {
 }
 
 void BasicThread::SetOSName(const char* arg_name) {
+    // Threads running on a pool don't have an OS thread of their own.
+    if ( pooled )
+        return;
+
     // Do it only if libc++ supports pthread_t.
     if constexpr ( std::is_same_v<std::thread::native_handle_type, pthread_t> )
         zeek::util::detail::set_thread_name(arg_name, reinterpret_cast<pthread_t>(thread.native_handle()));
 }
 
-const char* BasicThread::Fmt(const char* format, ...) {
-    if ( buf_len > 10 * STD_FMT_BUF_LEN ) {
-        // Shrink back to normal.
+// Formats into a buffer, growing it as needed.
+static const char* vfmt(char*& buf, uint32_t& buf_len, const char* format, va_list al) {
+    if ( ! buf || buf_len > 10 * STD_FMT_BUF_LEN ) {
+        // Allocate, or shrink back to normal.
         buf = (char*)util::safe_realloc(buf, STD_FMT_BUF_LEN);
         buf_len = STD_FMT_BUF_LEN;
     }
 
-    va_list al;
-    va_start(al, format);
-    int n = vsnprintf(buf, buf_len, format, al);
-    va_end(al);
+    va_list al_copy;
+    va_copy(al_copy, al);
+    int n = vsnprintf(buf, buf_len, format, al_copy);
+    va_end(al_copy);
 
     if ( (unsigned int)n >= buf_len ) { // Not enough room, grow the buffer.
         buf_len = n + 32;
         buf = (char*)util::safe_realloc(buf, buf_len);
-
-        // Is it portable to restart?
-        va_start(al, format);
         n = vsnprintf(buf, buf_len, format, al);
-        va_end(al);
     }
 
     return buf;
 }
 
+// Fmt() buffer for threads calling Fmt() on a thread other than their own,
+// such as helper threads that a reader spawns.
+struct ForeignFmtBuffer {
+    char* buf = nullptr;
+    uint32_t buf_len = 0;
+
+    ~ForeignFmtBuffer() { free(buf); }
+};
+
+static thread_local ForeignFmtBuffer foreign_fmt_buffer;
+
+const char* BasicThread::Fmt(const char* format, ...) {
+    va_list al;
+    va_start(al, format);
+
+    const char* result;
+
+    if ( started && ! pooled && std::this_thread::get_id() != thread_id.load(std::memory_order_relaxed) )
+        result = vfmt(foreign_fmt_buffer.buf, foreign_fmt_buffer.buf_len, format, al);
+    else
+        result = vfmt(buf, buf_len, format, al);
+
+    va_end(al);
+    return result;
+}
+
 const char* BasicThread::Strerror(int err) {
     if ( ! strerr_buffer )
         strerr_buffer = new char[256];
@@ -87,6 +118,13 @@ void BasicThread::Start() {
 
     started = true;
 
+    if ( OnStartPooled() ) {
+        pooled = true;
+        DBG_LOG(DBG_THREADING, "Started thread %s on a pool", name);
+        OnStart();
+        return;
+    }
+
     thread = std::thread(&BasicThread::launcher, this);
 
     DBG_LOG(DBG_THREADING, "Started thread %s", name);
@@ -121,6 +159,12 @@ void BasicThread::Join() {
     if ( ! started )
         return;
 
+    if ( pooled ) {
+        OnJoinPooled();
+        DBG_LOG(DBG_THREADING, "Joined with pooled thread %s", name);
+        return;
+    }
+
     if ( ! thread.joinable() )
         return;
 
@@ -151,9 +195,7 @@ void BasicThread::Done() {
     killed = true;
 }
 
-void* BasicThread::launcher(void* arg) {
-    BasicThread* thread = (BasicThread*)arg;
-
+void BasicThread::BlockSignals() {
 #ifndef _MSC_VER
     // Block signals in thread. We handle signals only in the main
     // process.
@@ -170,6 +212,14 @@ void* BasicThread::launcher(void* arg) {
     int res = pthread_sigmask(SIG_BLOCK, &mask_set, 0);
     assert(res == 0);
 #endif
+}
+
+void* BasicThread::launcher(void* arg) {
+    BasicThread* thread = (BasicThread*)arg;
+
+    thread->thread_id.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    BlockSignals();
 
     // Run thread's main function.
     thread->Run();
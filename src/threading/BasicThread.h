@@ -65,8 +65,9 @@ public:
 
     /**
      * Starts the thread. Calling this methods will spawn a new OS thread
-     * executing Run(). Note that one can't restart a thread after a
-     * Stop(), doing so will be ignored.
+     * executing Run(), unless OnStartPooled() arranges otherwise. Note
+     * that one can't restart a thread after a Stop(), doing so will be
+     * ignored.
      *
      * Only Zeek's main thread must call this method.
      */
@@ -115,8 +116,10 @@ public:
     /**
      * A version of zeek::util::fmt() that the thread can safely use.
      *
-     * This is safe to call from Run() but must not be used from any
-     * other thread than the current one.
+     * This is safe to call from Run(). When called from any other
+     * thread, the result goes into a buffer private to the calling
+     * thread instead, so helper threads can use it as well. Either way,
+     * the result remains valid only until the next call.
      */
     const char* Fmt(const char* format, ...) __attribute__((format(printf, 2, 3)));
     ;
@@ -129,6 +132,12 @@ public:
      */
     const char* Strerror(int err);
 
+    /**
+     * Blocks the signals that Zeek handles on its main thread for the
+     * calling thread. Threads started by Start() do this automatically.
+     */
+    static void BlockSignals();
+
 protected:
     friend class Manager;
 
@@ -148,6 +157,22 @@ protected:
      */
     virtual void OnStart() {}
 
+    /**
+     * Executed with Start() before an OS thread gets spawned. A derived
+     * class may return true after arranging for its work to execute on
+     * threads shared with others, in which case Start() doesn't spawn a
+     * thread of its own, and Join() calls OnJoinPooled() instead of
+     * joining one. It will be called from Zeek's main thread.
+     */
+    virtual bool OnStartPooled() { return false; }
+
+    /**
+     * Executed with Join() for a thread that OnStartPooled() arranged to
+     * run on shared threads. It must only return once the thread's work
+     * has finished executing. It will be called from Zeek's main thread.
+     */
+    virtual void OnJoinPooled() {}
+
     /**
      * Executed with SignalStop(). This is a hook into preparing the
      * thread for stopping. It will be called from Zeek's main thread
@@ -200,7 +225,9 @@ private:
 
     const char* name;
     std::thread thread;
+    std::atomic<std::thread::id> thread_id; // Set by the child itself, as thread may still be getting assigned.
     bool started;                 // Set to to true once running.
+    bool pooled;                  // Set to true if running on shared threads.
     std::atomic_bool terminating; // Set to to true to signal termination.
     std::atomic_bool killed;      // Set to true once forcefully killed.
 
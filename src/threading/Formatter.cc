@@ -92,11 +92,13 @@ std::string Formatter::Render(const threading::Value::subnet_t& subnet) {
 }
 
 std::string Formatter::Render(double d) {
-    char buf[256];
-    modp_dtoa(d, buf, 6);
-    return buf;
+    char buf[util::NUMBER_BUFFER_SIZE];
+    auto len = Render(d, buf);
+    return {buf, len};
 }
 
+size_t Formatter::Render(double d, char* buf) { return util::format_double(d, 6, buf); }
+
 std::string Formatter::Render(TransportProto proto) {
     if ( proto == TRANSPORT_UDP )
         return "udp";
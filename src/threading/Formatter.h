@@ -115,6 +115,19 @@ public:
      */
     static std::string Render(double d);
 
+    /**
+     * Convert a double into a string like Render(double), but into a
+     * caller-provided buffer instead of allocating.
+     *
+     * @param d The double.
+     *
+     * @param buf Receives the null-terminated result. Must have room for
+     * util::NUMBER_BUFFER_SIZE characters.
+     *
+     * @return The length of the result.
+     */
+    static size_t Render(double d, char* buf);
+
     /**
      * Convert a transport protocol into a string.
      *
@@ -10,6 +10,7 @@
 #include "zeek/NetVar.h"
 #include "zeek/RunState.h"
 #include "zeek/telemetry/Manager.h"
+#include "zeek/threading/ThreadPool.h"
 
 namespace zeek::threading {
 namespace detail {
@@ -80,6 +81,14 @@ void Manager::InitPostScript() {
             return thread_mgr ? static_cast<double>(thread_mgr->all_threads.size()) : 0.0;
         });
 
+    num_pool_threads_metric =
+        telemetry_mgr->GaugeInstance("zeek", "msgthread_pool_threads", {}, "Number of threads of the writer pool", "",
+                                     []() {
+                                         return thread_mgr && thread_mgr->writer_pool ?
+                                                    static_cast<double>(thread_mgr->writer_pool->NumThreads()) :
+                                                    0.0;
+                                     });
+
     total_threads_metric = telemetry_mgr->CounterInstance("zeek", "msgthread_threads", {}, "Total number of threads");
     total_messages_in_metric =
         telemetry_mgr->CounterInstance("zeek", "msgthread_in_messages", {}, "Number of inbound messages received", "");
@@ -153,6 +162,10 @@ void Manager::Terminate() {
 
     all_threads.clear();
     msg_threads.clear();
+
+    // All threads running on the pool have finished now.
+    writer_pool.reset();
+
     terminating = false;
     terminated = true;
 }
@@ -227,6 +240,15 @@ void Manager::StartHeartbeatTimer() {
         new detail::HeartbeatTimer(run_state::network_time + BifConst::Threading::heartbeat_interval));
 }
 
+detail::ThreadPool* Manager::WriterPool() {
+    if ( ! writer_pool && ! terminated && BifConst::Threading::writer_pool_size > 0 ) {
+        DBG_LOG(DBG_THREADING, "Starting writer pool with %" PRIu64 " threads", BifConst::Threading::writer_pool_size);
+        writer_pool = std::make_unique<detail::ThreadPool>(BifConst::Threading::writer_pool_size);
+    }
+
+    return writer_pool.get();
+}
+
 void Manager::MessageIn() { total_messages_in_metric->Inc(); }
 
 void Manager::MessageOut() { total_messages_out_metric->Inc(); }
@@ -296,7 +318,7 @@ void Manager::Flush() {
             t->Heartbeat();
 
         while ( t->HasOut() ) {
-            Message* msg = t->RetrieveOut();
+            BasicOutputMessage* msg = t->RetrieveOut();
             assert(msg);
 
             if ( msg->Process() ) {
@@ -309,7 +331,7 @@ void Manager::Flush() {
                 t->SignalStop();
             }
 
-            delete msg;
+            t->FinishOut(msg);
         }
     }
 
@@ -2,6 +2,7 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <utility>
 
 #include "zeek/Timer.h"
@@ -21,6 +22,8 @@ using CounterPtr = std::shared_ptr<Counter>;
 namespace threading {
 namespace detail {
 
+class ThreadPool;
+
 class HeartbeatTimer final : public zeek::detail::Timer {
 public:
     HeartbeatTimer(double t) : zeek::detail::Timer(t, zeek::detail::TIMER_THREAD_HEARTBEAT) {}
@@ -163,6 +166,13 @@ protected:
      */
     void MessageOut();
 
+    /**
+     * Returns the pool that log writers run on, starting it on first use,
+     * or null if Threading::writer_pool_size is zero and each writer
+     * runs on a thread of its own.
+     */
+    detail::ThreadPool* WriterPool();
+
 private:
     using all_thread_list = std::list<BasicThread*>;
     all_thread_list all_threads;
@@ -177,8 +187,11 @@ private:
 
     msg_stats_list stats;
 
+    std::unique_ptr<detail::ThreadPool> writer_pool;
+
     bool heartbeat_timer_running = false;
     telemetry::GaugePtr num_threads_metric;
+    telemetry::GaugePtr num_pool_threads_metric;
     telemetry::CounterPtr total_threads_metric;
     telemetry::CounterPtr total_messages_in_metric;
     telemetry::CounterPtr total_messages_out_metric;
@@ -2,7 +2,10 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <algorithm>
 #include <csignal>
+#include <deque>
+#include <mutex>
 
 #include "zeek/DebugLogger.h"
 #include "zeek/Desc.h"
@@ -11,6 +14,7 @@
 #include "zeek/iosource/Manager.h"
 #include "zeek/telemetry/Manager.h"
 #include "zeek/threading/Manager.h"
+#include "zeek/threading/ThreadPool.h"
 
 // Set by Zeek's main signal handler.
 extern int signal_val;
@@ -58,7 +62,10 @@ public:
         current_time = arg_current_time;
     }
 
-    bool Process() override { return Object()->OnHeartbeat(network_time, current_time); }
+    bool Process() override {
+        Object()->heartbeat_pending = false;
+        return Object()->OnHeartbeat(network_time, current_time);
+    }
 
 private:
     double network_time;
@@ -166,50 +173,113 @@ bool ReporterMessage::Process() {
     return true;
 }
 
-// This is the IO source used by MsgThread.
+// This is the IO source used by MsgThreads. A single instance is shared by
+// all of them: a thread puts itself on a ready list when it queues a message
+// for the main thread, and the flare fires only when that list becomes
+// non-empty. Processing then visits just the threads on the list, instead
+// of all threads having their own flare that the IO manager needs to watch.
 //
-// The lifetime of the IO source is decoupled from
-// the thread. The thread may be terminated prior
-// to the IO source being properly unregistered and
+// The lifetime of the IO source is decoupled from the threads. A thread
+// may be terminated prior to the IO source being properly unregistered and
 // removed by the IO manager.
 class IOSource : public iosource::IOSource {
 public:
-    explicit IOSource(MsgThread* thread) : thread(thread) {
+    IOSource() {
         if ( ! iosource_mgr->RegisterFd(flare.FD(), this) )
             reporter->InternalError("Failed to register MsgThread FD with iosource_mgr");
 
         SetClosed(false);
     }
 
-    ~IOSource() override {
-        if ( ! iosource_mgr->UnregisterFd(flare.FD(), this) )
-            reporter->InternalError("Failed to unregister MsgThread FD from iosource_mgr");
-    }
+    ~IOSource() override;
 
     void Process() override {
         flare.Extinguish();
 
-        if ( thread )
+        // Visit the threads that are ready right now. Threads becoming
+        // ready while we're at it get their turn with the next round.
+        size_t num_ready;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            num_ready = ready.size();
+        }
+
+        for ( size_t i = 0; i < num_ready; i++ ) {
+            MsgThread* thread;
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+
+                if ( ready.empty() )
+                    break;
+
+                thread = ready.front();
+                ready.pop_front();
+                thread->io_ready = false;
+            }
+
             thread->Process();
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+
+        if ( ! ready.empty() )
+            flare.Fire();
     }
 
-    const char* Tag() override { return thread ? thread->Name() : "<MsgThread orphan>"; }
+    const char* Tag() override { return "MsgThreads"; }
 
     double GetNextTimeout() override { return -1; }
 
+    /**
+     * Notes that a thread has messages pending for the main thread.
+     */
+    void Ready(MsgThread* thread) {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        if ( thread->io_ready || thread->io_closed )
+            return;
 
-    void Fire() { flare.Fire(); };
+        thread->io_ready = true;
+        ready.push_back(thread);
 
-    void Close() {
-        thread = nullptr;
-        SetClosed(true);
+        if ( ready.size() == 1 ) {
+            lock.unlock();
+            flare.Fire();
+        }
+    }
+
+    /**
+     * Stops processing a thread's messages.
+     */
+    void Close(MsgThread* thread) {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        thread->io_closed = true;
+
+        if ( thread->io_ready ) {
+            ready.erase(std::find(ready.begin(), ready.end(), thread));
+            thread->io_ready = false;
+        }
     }
 
 private:
-    MsgThread* thread = nullptr;
+    std::mutex mtx;
+    std::deque<MsgThread*> ready; // Threads with pending messages, guarded by mtx.
     zeek::detail::Flare flare;
 };
 
+// The IO source shared by all threads, created with the first one.
+static IOSource* io_source = nullptr;
+
+IOSource::~IOSource() {
+    if ( ! iosource_mgr->UnregisterFd(flare.FD(), this) )
+        reporter->InternalError("Failed to unregister MsgThread FD from iosource_mgr");
+
+    io_source = nullptr;
+}
+
 } // namespace detail
 
 ////// Methods.
@@ -226,20 +296,22 @@ MsgThread::MsgThread() : BasicThread(), queue_in(this, nullptr), queue_out(nullp
     failed = false;
     thread_mgr->AddMsgThread(this);
 
-    io_source = new detail::IOSource(this);
+    if ( ! detail::io_source ) {
+        detail::io_source = new detail::IOSource();
 
-    // Register IOSource as non-counting lifetime managed IO source.
-    iosource_mgr->Register(io_source, true);
+        // Register IOSource as non-counting lifetime managed IO source.
+        iosource_mgr->Register(detail::io_source, true);
+    }
 }
 
 MsgThread::~MsgThread() {
     // Unregister this thread from the IO source so we don't
     // get Process() callbacks anymore. The IO source itself
     // is life-time managed by the IO manager.
-    if ( io_source ) {
-        io_source->Close();
-        io_source = nullptr;
-    }
+    if ( detail::io_source )
+        detail::io_source->Close(this);
+
+    delete pending_out;
 }
 
 void MsgThread::OnSignalStop() {
@@ -285,13 +357,13 @@ void MsgThread::OnWaitForStop() {
             queue_in.WakeUp();
 
         while ( HasOut() ) {
-            Message* msg = RetrieveOut();
+            BasicOutputMessage* msg = RetrieveOut();
             assert(msg);
 
             if ( ! msg->Process() )
                 reporter->Error("%s failed during thread termination", msg->Name());
 
-            delete msg;
+            FinishOut(msg);
         }
 
         if ( ! Killed() )
@@ -305,21 +377,43 @@ void MsgThread::OnKill() {
     // Ensure the IO source is closed and won't call Process() on this
     // thread anymore. The thread got killed, so the threading manager will
     // remove it forcefully soon.
-    if ( io_source ) {
-        io_source->Close();
-        io_source = nullptr;
-    }
+    if ( detail::io_source )
+        detail::io_source->Close(this);
 
     // Send a message to unblock the reader if its currently waiting for
     // input. This is just an optimization to make it terminate more
     // quickly, even without the message it will eventually time out.
     queue_in.WakeUp();
+
+    // On a pool, the thread needs to get scheduled to notice.
+    if ( pool )
+        pool->Schedule(this);
 }
 
+bool MsgThread::OnStartPooled() {
+    if ( ! CanRunOnPool() )
+        return false;
+
+    auto* writer_pool = thread_mgr->WriterPool();
+
+    if ( ! writer_pool )
+        return false;
+
+    writer_pool->Add(this);
+    return true;
+}
+
+void MsgThread::OnJoinPooled() { pool->Wait(this); }
+
 void MsgThread::Heartbeat() {
     if ( child_sent_finish )
         return;
 
+    // Coalesce heartbeats for a thread that hasn't gotten to the
+    // previous one yet.
+    if ( heartbeat_pending.exchange(true) )
+        return;
+
     SendIn(new detail::HeartbeatMessage(this, run_state::network_time, util::current_time()));
 }
 
@@ -390,6 +484,9 @@ void MsgThread::SendIn(BasicInputMessage* msg, bool force) {
     ++cnt_sent_in;
 
     zeek::thread_mgr->MessageIn();
+
+    if ( pool )
+        pool->Schedule(this);
 }
 
 void MsgThread::SendOut(BasicOutputMessage* msg, bool force) {
@@ -404,8 +501,8 @@ void MsgThread::SendOut(BasicOutputMessage* msg, bool force) {
 
     zeek::thread_mgr->MessageOut();
 
-    if ( io_source )
-        io_source->Fire();
+    if ( detail::io_source )
+        detail::io_source->Ready(this);
 }
 
 void MsgThread::SendEvent(const char* name, const int num_vals, Value** vals) {
@@ -413,6 +510,12 @@ void MsgThread::SendEvent(const char* name, const int num_vals, Value** vals) {
 }
 
 BasicOutputMessage* MsgThread::RetrieveOut() {
+    if ( pending_out ) {
+        BasicOutputMessage* msg = pending_out;
+        pending_out = nullptr;
+        return msg;
+    }
+
     BasicOutputMessage* msg = queue_out.Get();
     if ( ! msg )
         return nullptr;
@@ -422,6 +525,16 @@ BasicOutputMessage* MsgThread::RetrieveOut() {
     return msg;
 }
 
+bool MsgThread::FinishOut(BasicOutputMessage* msg) {
+    if ( msg->Pending() ) {
+        pending_out = msg;
+        return true;
+    }
+
+    delete msg;
+    return false;
+}
+
 BasicInputMessage* MsgThread::RetrieveIn() {
     BasicInputMessage* msg = queue_in.Get();
 
@@ -443,20 +556,7 @@ void MsgThread::Run() {
         if ( ! msg )
             continue;
 
-        bool result = msg->Process();
-
-        delete msg;
-
-        if ( ! result ) {
-            Error("terminating thread");
-
-            // This will eventually kill this thread, but only
-            // after all other outgoing messages (in particular
-            // error messages have been processed by then main
-            // thread).
-            SendOut(new detail::KillMeMessage(this));
-            failed = true;
-        }
+        ProcessIn(msg);
     }
 
     // In case we haven't sent the finish method yet, do it now. Reading
@@ -468,6 +568,41 @@ void MsgThread::Run() {
     }
 }
 
+void MsgThread::ProcessIn(BasicInputMessage* msg) {
+    bool result = msg->Process();
+
+    delete msg;
+
+    if ( ! result ) {
+        Error("terminating thread");
+
+        // This will eventually kill this thread, but only
+        // after all other outgoing messages (in particular
+        // error messages have been processed by then main
+        // thread).
+        SendOut(new detail::KillMeMessage(this));
+        failed = true;
+    }
+}
+
+bool MsgThread::RunPooled(size_t max_messages) {
+    for ( size_t i = 0; i < max_messages && ! (child_finished || Killed()) && HasIn(); i++ ) {
+        BasicInputMessage* msg = RetrieveIn();
+
+        if ( ! msg )
+            break;
+
+        ProcessIn(msg);
+    }
+
+    if ( ! (child_finished || Killed()) )
+        return false;
+
+    // Equivalent to returning from Run() on a thread of our own.
+    Done();
+    return true;
+}
+
 void MsgThread::GetStats(Stats* stats) {
     stats->sent_in = cnt_sent_in.load();
     stats->sent_out = cnt_sent_out.load();
@@ -478,8 +613,11 @@ void MsgThread::GetStats(Stats* stats) {
 }
 
 void MsgThread::Process() {
+    double max_time = MaxProcessTime();
+    double deadline = max_time > 0.0 ? util::current_time(true) + max_time : 0.0;
+
     while ( HasOut() ) {
-        Message* msg = RetrieveOut();
+        BasicOutputMessage* msg = RetrieveOut();
         assert(msg);
 
         if ( ! msg->Process() ) {
@@ -487,7 +625,16 @@ void MsgThread::Process() {
             SignalStop();
         }
 
-        delete msg;
+        // A pending message has used up the time already.
+        bool pending = FinishOut(msg);
+
+        if ( pending || (deadline > 0.0 && HasOut() && util::current_time(true) > deadline) ) {
+            // Come back for the rest with the next round.
+            if ( detail::io_source )
+                detail::io_source->Ready(this);
+
+            break;
+        }
     }
 }
 
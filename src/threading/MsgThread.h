@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 
 #include "zeek/DebugLogger.h"
 #include "zeek/threading/BasicThread.h"
@@ -10,6 +11,10 @@ namespace zeek::detail {
 class Location;
 }
 
+namespace zeek::telemetry {
+class Counter;
+}
+
 namespace zeek::threading {
 
 struct Value;
@@ -25,6 +30,7 @@ class FinishMessage;
 class FinishedMessage;
 class KillMeMessage;
 class IOSource;
+class ThreadPool;
 
 } // namespace detail
 
@@ -218,6 +224,7 @@ protected:
     friend class detail::FinishMessage;
     friend class detail::FinishedMessage;
     friend class detail::KillMeMessage;
+    friend class detail::IOSource;
 
     /**
      * Pops a message sent by the child from the child-to-main queue.
@@ -229,6 +236,15 @@ protected:
      */
     BasicOutputMessage* RetrieveOut();
 
+    /**
+     * Disposes of a message retrieved with RetrieveOut() once the main
+     * thread has processed it. A message that has work left, see
+     * Message::Pending(), gets retrieved again first instead.
+     *
+     * @return True if the message is still pending.
+     */
+    bool FinishOut(BasicOutputMessage* msg);
+
     /**
      * Triggers a heartbeat message being sent to the client thread.
      *
@@ -271,6 +287,29 @@ protected:
     void OnWaitForStop() override;
     void OnSignalStop() override;
     void OnKill() override;
+    bool OnStartPooled() override;
+    void OnJoinPooled() override;
+
+    /**
+     * Method for child classes to override to indicate that they may run
+     * on the shared pool of threads configured through
+     * Threading::writer_pool_size, instead of on a thread of their own.
+     * Their messages still get processed sequentially and in order, but
+     * not necessarily always by the same OS thread.
+     *
+     * @return True if the thread may run on the pool.
+     */
+    virtual bool CanRunOnPool() const { return false; }
+
+    /**
+     * Method for child classes to override to limit the time the main
+     * thread spends processing their messages in one go. Once that time
+     * is up, the main thread leaves any remaining messages for its next
+     * loop iteration, so that other work gets its turn in between.
+     *
+     * @return The time limit in seconds, or zero for no limit.
+     */
+    virtual double MaxProcessTime() const { return 0.0; }
 
     /**
      * Method for child classes to override to provide file location
@@ -284,6 +323,26 @@ protected:
     virtual const zeek::detail::Location* GetLocationInfo() const { return nullptr; }
 
 private:
+    friend class detail::ThreadPool;
+
+    /**
+     * Processes a message sent by the main thread. Takes ownership of
+     * the message.
+     *
+     * Must only be called by the child thread.
+     */
+    void ProcessIn(BasicInputMessage* msg);
+
+    /**
+     * Processes pending messages when running on a pool. Called by the
+     * pool for one thread at a time.
+     *
+     * @param max_messages The maximum number of messages to process.
+     *
+     * @return True if the thread has finished.
+     */
+    bool RunPooled(size_t max_messages);
+
     /**
      * Pops a message sent by the main thread from the main-to-chold
      * queue.
@@ -331,14 +390,14 @@ private:
      * Returns true if there's at least one message pending for the main
      * thread.
      */
-    bool HasOut() { return queue_out.Ready(); }
+    bool HasOut() { return pending_out || queue_out.Ready(); }
 
     /**
      * Returns true if there might be at least one message pending for
      * the main thread. This function may occasionally return a value not
      * indicating the actual state, but won't do so very often.
      */
-    bool MightHaveOut() { return queue_out.MaybeReady(); }
+    bool MightHaveOut() { return pending_out || queue_out.MaybeReady(); }
 
     /** Sends a message to the main thread signaling that the child process
      *  has finished processing. Called from child.
@@ -349,6 +408,7 @@ private:
 
     Queue<BasicInputMessage*> queue_in;
     Queue<BasicOutputMessage*> queue_out;
+    BasicOutputMessage* pending_out = nullptr; // Message to continue processing first, main thread only.
 
     std::atomic<uint64_t> cnt_sent_in;  // Counts message sent to child.
     std::atomic<uint64_t> cnt_sent_out; // Counts message sent by child.
@@ -359,7 +419,15 @@ private:
     bool child_sent_finish; // Child thread asked to be finished.
     bool failed;            // Set to true when a command failed.
 
-    detail::IOSource* io_source = nullptr; // IO source registered with the IO manager.
+    bool io_ready = false;  // On the IO source's ready list, guarded by the IO source.
+    bool io_closed = false; // Removed from the IO source, guarded by the IO source.
+
+    std::atomic<bool> heartbeat_pending = false; // A heartbeat is queued for the child.
+
+    detail::ThreadPool* pool = nullptr; // The pool the thread runs on, if any.
+    bool pool_scheduled = false;        // Queued or running on the pool, guarded by the pool.
+    bool pool_done = false;             // Finished running on the pool, guarded by the pool.
+    std::shared_ptr<telemetry::Counter> pool_cpu_metric;
 };
 
 /**
@@ -384,6 +452,13 @@ public:
      */
     virtual bool Process() = 0; // Thread will be terminated if returning false.
 
+    /**
+     * Returns true if the last call to Process() stopped before completing
+     * the message, to stay within the thread's MaxProcessTime(). The main
+     * thread then calls Process() again before any later message.
+     */
+    virtual bool Pending() const { return false; }
+
 protected:
     /**
      * Constructor.
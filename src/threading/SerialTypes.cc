@@ -124,6 +124,7 @@ Value::Value(Value&& other) noexcept {
     present = other.present;
     type = other.type;
     subtype = other.type;
+    borrowed = other.borrowed;
     line_number = other.line_number;
 
     val = other.val; // take ownership.
@@ -131,14 +132,17 @@ Value::Value(Value&& other) noexcept {
     other.val = _val();
     other.line_number = -1;
     other.present = false;
+    other.borrowed = false;
 }
 
 Value::~Value() {
     if ( ! present )
         return;
 
-    if ( type == TYPE_ENUM || type == TYPE_STRING || type == TYPE_FILE || type == TYPE_FUNC )
-        delete[] val.string_val.data;
+    if ( type == TYPE_ENUM || type == TYPE_STRING || type == TYPE_FILE || type == TYPE_FUNC ) {
+        if ( ! borrowed )
+            delete[] val.string_val.data;
+    }
 
     else if ( type == TYPE_PATTERN )
         delete[] val.pattern_text_val;
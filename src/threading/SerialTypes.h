@@ -104,9 +104,10 @@ private:
  * those Vals supported).
  */
 struct Value {
-    TypeTag type;         //! The type of the value.
-    TypeTag subtype;      //! Inner type for sets and vectors.
-    bool present = false; //! False for optional record fields that are not set.
+    TypeTag type;          //! The type of the value.
+    TypeTag subtype;       //! Inner type for sets and vectors.
+    bool present = false;  //! False for optional record fields that are not set.
+    bool borrowed = false; //! True if string data is owned elsewhere, such as a log write batch.
 
     struct set_t {
         zeek_int_t size;
@@ -186,7 +187,7 @@ struct Value {
         : type(arg_type), subtype(arg_subtype), present(arg_present) {}
 
     /**
-     * Copy constructor.
+     * Copy constructor. The copy always owns its data.
      */
     Value(const Value& other);
 
@@ -0,0 +1,125 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/threading/ThreadPool.h"
+
+#include <ctime>
+
+#include "zeek/telemetry/Manager.h"
+#include "zeek/threading/MsgThread.h"
+#include "zeek/util.h"
+
+namespace zeek::threading::detail {
+
+// Maximum number of messages a MsgThread processes before the pool thread
+// moves on to the next scheduled one.
+static constexpr size_t MAX_MESSAGES_PER_TASK = 64;
+
+// Returns the CPU time the calling thread has consumed, in seconds.
+static double thread_cpu_time() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if ( clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0 )
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+
+    return 0.0;
+}
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    delay_metric = telemetry_mgr->ShardedHistogramInstance("zeek", "msgthread_pool_queue_delay", {},
+                                                           {0.0001, 0.001, 0.01, 0.1, 1.0, 10.0},
+                                                           "Time threads waited for a pool thread to process their "
+                                                           "messages",
+                                                           "seconds");
+    cpu_family = telemetry_mgr->CounterFamily("zeek", "msgthread_pool_cpu", {"thread"},
+                                              "CPU time spent processing messages of threads running on the pool",
+                                              "seconds");
+
+    for ( size_t i = 0; i < num_threads; i++ )
+        threads.emplace_back([this]() {
+            BasicThread::BlockSignals();
+            util::detail::set_thread_name("zk.writer-pool");
+            Work();
+        });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+
+    work_cv.notify_all();
+
+    for ( auto& t : threads )
+        t.join();
+}
+
+void ThreadPool::Add(MsgThread* thread) {
+    thread->pool = this;
+    thread->pool_cpu_metric = cpu_family->GetOrAdd({{"thread", thread->Name()}});
+}
+
+void ThreadPool::Schedule(MsgThread* thread) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        if ( thread->pool_scheduled || thread->pool_done )
+            return;
+
+        thread->pool_scheduled = true;
+        tasks.push_back({thread, std::chrono::steady_clock::now()});
+    }
+
+    work_cv.notify_one();
+}
+
+void ThreadPool::Wait(MsgThread* thread) {
+    std::unique_lock<std::mutex> lock(mtx);
+    done_cv.wait(lock, [thread]() { return thread->pool_done; });
+}
+
+void ThreadPool::Work() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while ( true ) {
+        work_cv.wait(lock, [this]() { return stopping || ! tasks.empty(); });
+
+        if ( tasks.empty() )
+            return;
+
+        Task task = tasks.front();
+        tasks.pop_front();
+
+        lock.unlock();
+
+        auto delay = std::chrono::steady_clock::now() - task.scheduled;
+        delay_metric->Observe(std::chrono::duration<double>(delay).count());
+
+        MsgThread* thread = task.thread;
+        double cpu_start = thread_cpu_time();
+        bool finished = thread->RunPooled(MAX_MESSAGES_PER_TASK);
+        thread->pool_cpu_metric->Inc(thread_cpu_time() - cpu_start);
+
+        lock.lock();
+
+        if ( finished ) {
+            // The main thread may delete the MsgThread once this is set.
+            thread->pool_done = true;
+            thread->pool_scheduled = false;
+            done_cv.notify_all();
+        }
+
+        else if ( thread->HasIn() || thread->Killed() ) {
+            // More to do, requeue at the end to give others a turn.
+            tasks.push_back({thread, std::chrono::steady_clock::now()});
+            work_cv.notify_one();
+        }
+
+        else
+            thread->pool_scheduled = false;
+    }
+}
+
+} // namespace zeek::threading::detail
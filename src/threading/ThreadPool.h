@@ -0,0 +1,98 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zeek {
+
+namespace telemetry {
+class CounterFamily;
+using CounterFamilyPtr = std::shared_ptr<CounterFamily>;
+class ShardedHistogram;
+using ShardedHistogramPtr = std::shared_ptr<ShardedHistogram>;
+} // namespace telemetry
+
+namespace threading {
+
+class MsgThread;
+
+namespace detail {
+
+/**
+ * A fixed set of OS threads that MsgThreads can run on instead of each
+ * having a thread of its own, used for log writers if
+ * Threading::writer_pool_size is non-zero.
+ *
+ * A MsgThread gets scheduled whenever a message is sent to it. A pool
+ * thread then processes a limited number of its pending messages before
+ * moving on to the next scheduled MsgThread. A MsgThread is only ever
+ * executed by one pool thread at a time, so its messages are processed
+ * sequentially and in order, just like on a thread of its own.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor. Starts the pool threads.
+     *
+     * @param num_threads The number of threads.
+     */
+    explicit ThreadPool(size_t num_threads);
+
+    /**
+     * Destructor. Stops the pool threads. All MsgThreads running on the
+     * pool must have finished.
+     */
+    ~ThreadPool();
+
+    /**
+     * Adds a MsgThread to the pool. Must be called from the main thread.
+     */
+    void Add(MsgThread* thread);
+
+    /**
+     * Schedules a MsgThread to process its pending messages, if it isn't
+     * scheduled or running already.
+     */
+    void Schedule(MsgThread* thread);
+
+    /**
+     * Waits until a MsgThread has finished running. Must be called from
+     * the main thread.
+     */
+    void Wait(MsgThread* thread);
+
+    /**
+     * @return The number of pool threads.
+     */
+    size_t NumThreads() const { return threads.size(); }
+
+private:
+    struct Task {
+        MsgThread* thread;
+        std::chrono::steady_clock::time_point scheduled;
+    };
+
+    void Work();
+
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    std::deque<Task> tasks;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    telemetry::ShardedHistogramPtr delay_metric;
+    telemetry::CounterFamilyPtr cpu_family;
+};
+
+} // namespace detail
+} // namespace threading
+} // namespace zeek
@@ -84,12 +84,21 @@ bool Ascii::Describe(ODesc* desc, Value* val, const string& name) const {
             break;
 
         case TYPE_INTERVAL:
-        case TYPE_TIME:
+        case TYPE_TIME: {
             // Rendering via Render() keeps trailing 0s after the decimal
             // point. The difference with DOUBLE is mainly to keep the
             // log format consistent.
-            desc->Add(Render(val->val.double_val));
+            char buf[util::NUMBER_BUFFER_SIZE];
+            size_t len;
+
+            if ( val->type == TYPE_TIME )
+                len = time_formatter.Format(val->val.double_val, buf);
+            else
+                len = Render(val->val.double_val, buf);
+
+            desc->AddN(buf, len);
             break;
+        }
 
         case TYPE_ENUM:
         case TYPE_STRING:
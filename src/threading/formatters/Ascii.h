@@ -3,6 +3,7 @@
 #pragma once
 
 #include "zeek/threading/Formatter.h"
+#include "zeek/util.h"
 
 namespace zeek::threading::formatter {
 
@@ -55,6 +56,7 @@ private:
     bool CheckNumberError(const char* start, const char* end, bool nonneg_only = false) const;
 
     SeparatorInfo separators;
+    mutable util::TimeFormatter time_formatter;
 };
 
 } // namespace zeek::threading::formatter
@@ -14,26 +14,99 @@
 #include <cerrno>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "zeek/Desc.h"
 #include "zeek/threading/MsgThread.h"
 #include "zeek/threading/formatters/detail/json.h"
 
+#include "zeek/3rdparty/doctest.h"
+
 namespace zeek::threading::formatter {
 
+/**
+ * Per-instance caches for describing records.
+ */
+struct JSON::State {
+    // Output buffer, reused across records.
+    rapidjson::StringBuffer buffer;
+
+    // The fields the keys have been rendered for, and each field's name
+    // as a quoted and escaped JSON string.
+    const Field* const* fields = nullptr;
+    int num_fields = 0;
+    std::vector<std::string> keys;
+
+    // The second that iso8601_prefix holds the rendering of.
+    time_t iso8601_second = 0;
+    std::string iso8601_prefix;
+};
+
+// Returns true if the string consists of printable ASCII characters only,
+// which util::json_escape_utf8() would leave unchanged. Looks at eight
+// bytes at a time.
+static bool is_printable_ascii(const char* s, size_t len) {
+    constexpr uint64_t ones = 0x0101010101010101ULL;
+    constexpr uint64_t highs = 0x8080808080808080ULL;
+
+    size_t i = 0;
+
+    for ( ; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t) ) {
+        uint64_t x;
+        memcpy(&x, s + i, sizeof(x));
+
+        // Flags bytes with the high bit set, bytes below 0x20, and 0x7f.
+        uint64_t del = x ^ (ones * 0x7f);
+        if ( (x | ((x - ones * 0x20) & ~x) | ((del - ones) & ~del)) & highs )
+            return false;
+    }
+
+    for ( ; i < len; i++ ) {
+        auto c = static_cast<unsigned char>(s[i]);
+        if ( c < 0x20 || c >= 0x7f )
+            return false;
+    }
+
+    return true;
+}
+
 JSON::JSON(MsgThread* t, TimeFormat tf, bool arg_include_unset_fields)
-    : Formatter(t), timestamps(tf), include_unset_fields(arg_include_unset_fields) {}
+    : Formatter(t), timestamps(tf), include_unset_fields(arg_include_unset_fields), state(new State()) {}
+
+JSON::~JSON() = default;
 
 bool JSON::Describe(ODesc* desc, int num_fields, const Field* const* fields, Value** vals) const {
-    rapidjson::StringBuffer buffer;
+    if ( fields != state->fields || num_fields != state->num_fields ) {
+        // Render the keys the way the writer's Key() would, once for all
+        // records of a writer.
+        state->keys.clear();
+
+        for ( int i = 0; i < num_fields; i++ ) {
+            rapidjson::StringBuffer key_buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> key_writer(key_buffer);
+            key_writer.String(fields[i]->name);
+            state->keys.emplace_back(key_buffer.GetString(), key_buffer.GetSize());
+        }
+
+        state->fields = fields;
+        state->num_fields = num_fields;
+    }
+
+    auto& buffer = state->buffer;
+    buffer.Clear();
     zeek::json::detail::NullDoubleWriter writer(buffer);
 
     writer.StartObject();
 
     for ( int i = 0; i < num_fields; i++ ) {
-        if ( vals[i]->present || include_unset_fields )
-            BuildJSON(writer, vals[i], fields[i]->name);
+        if ( vals[i]->present || include_unset_fields ) {
+            const auto& key = state->keys[i];
+            writer.RawValue(key.data(), key.size(), rapidjson::kStringType);
+            BuildJSON(writer, vals[i]);
+        }
     }
 
     writer.EndObject();
@@ -94,30 +167,8 @@ void JSON::BuildJSON(zeek::json::detail::NullDoubleWriter& writer, Value* val, c
         case TYPE_INTERVAL: writer.Double(val->val.double_val); break;
 
         case TYPE_TIME: {
-            if ( timestamps == TS_ISO8601 ) {
-                char buffer[40];
-                char buffer2[48];
-                time_t the_time = time_t(floor(val->val.double_val));
-                struct tm t;
-
-                if ( ! gmtime_r(&the_time, &t) || ! strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &t) ) {
-                    GetThread()->Error(
-                        GetThread()->Fmt("json formatter: failure getting time: (%lf)", val->val.double_val));
-                    // This was a failure, doesn't really matter what gets put here
-                    // but it should probably stand out...
-                    writer.String("2000-01-01T00:00:00.000000");
-                }
-                else {
-                    double integ;
-                    double frac = modf(val->val.double_val, &integ);
-
-                    if ( frac < 0 )
-                        frac += 1;
-
-                    snprintf(buffer2, sizeof(buffer2), "%s.%06.0fZ", buffer, fabs(frac) * 1000000);
-                    writer.String(buffer2, strlen(buffer2));
-                }
-            }
+            if ( timestamps == TS_ISO8601 )
+                BuildISO8601(writer, val->val.double_val);
 
             else if ( timestamps == TS_EPOCH )
                 writer.Double(val->val.double_val);
@@ -134,7 +185,14 @@ void JSON::BuildJSON(zeek::json::detail::NullDoubleWriter& writer, Value* val, c
         case TYPE_STRING:
         case TYPE_FILE:
         case TYPE_FUNC: {
-            writer.String(util::json_escape_utf8(std::string(val->val.string_val.data, val->val.string_val.length)));
+            const char* data = val->val.string_val.data;
+            int len = val->val.string_val.length;
+
+            if ( is_printable_ascii(data, len) )
+                writer.String(data, len);
+            else
+                writer.String(util::json_escape_utf8(data, len));
+
             break;
         }
 
@@ -162,4 +220,114 @@ void JSON::BuildJSON(zeek::json::detail::NullDoubleWriter& writer, Value* val, c
     }
 }
 
+void JSON::BuildISO8601(zeek::json::detail::NullDoubleWriter& writer, double ts) const {
+    time_t the_time = time_t(floor(ts));
+
+    // Timestamps of consecutive records tend to fall into the same second,
+    // so only the fractional part needs rendering for most of them.
+    if ( state->iso8601_prefix.empty() || the_time != state->iso8601_second ) {
+        char buffer[40];
+        struct tm t;
+
+        if ( ! gmtime_r(&the_time, &t) || ! strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &t) ) {
+            GetThread()->Error(GetThread()->Fmt("json formatter: failure getting time: (%lf)", ts));
+            // This was a failure, doesn't really matter what gets put here
+            // but it should probably stand out...
+            writer.String("2000-01-01T00:00:00.000000");
+            return;
+        }
+
+        state->iso8601_second = the_time;
+        state->iso8601_prefix = buffer;
+    }
+
+    double integ;
+    double frac = modf(ts, &integ);
+
+    if ( frac < 0 )
+        frac += 1;
+
+    // Rounds like the "%06.0f" this used to be rendered with, including
+    // the carry to 1000000.
+    auto usecs = static_cast<uint64_t>(nearbyint(fabs(frac) * 1000000));
+
+    char digits[24];
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + usecs % 10;
+        usecs /= 10;
+    } while ( usecs );
+
+    while ( n < 6 )
+        digits[n++] = '0';
+
+    char result[64];
+    size_t len = state->iso8601_prefix.size();
+    memcpy(result, state->iso8601_prefix.data(), len);
+    result[len++] = '.';
+
+    while ( n > 0 )
+        result[len++] = digits[--n];
+
+    result[len++] = 'Z';
+    writer.String(result, len);
+}
+
+TEST_SUITE_BEGIN("JSON formatter");
+
+TEST_CASE("formatter.json iso8601 timestamps") {
+    JSON json(nullptr, JSON::TS_ISO8601);
+
+    auto describe = [&json](double ts) {
+        Value val(TYPE_TIME);
+        val.val.double_val = ts;
+
+        ODesc desc;
+        json.Describe(&desc, &val, "ts");
+        return std::string(desc.Description());
+    };
+
+    CHECK(describe(0.0) == R"({"ts":"1970-01-01T00:00:00.000000Z"})");
+    CHECK(describe(1.5) == R"({"ts":"1970-01-01T00:00:01.500000Z"})");
+    CHECK(describe(1.000001) == R"({"ts":"1970-01-01T00:00:01.000001Z"})");
+    CHECK(describe(1.0000004) == R"({"ts":"1970-01-01T00:00:01.000000Z"})");
+    CHECK(describe(1300475167.0961) == R"({"ts":"2011-03-18T19:06:07.096100Z"})");
+    CHECK(describe(-0.25) == R"({"ts":"1969-12-31T23:59:59.750000Z"})");
+
+    // Like the former "%06.0f", a fraction rounding up to a full second
+    // doesn't carry over into the seconds.
+    CHECK(describe(2.9999999) == R"({"ts":"1970-01-01T00:00:02.1000000Z"})");
+}
+
+TEST_CASE("formatter.json field names and strings") {
+    JSON json(nullptr, JSON::TS_EPOCH);
+
+    Field f1("a\"b", nullptr, TYPE_STRING, TYPE_VOID, false);
+    Field f2("c", nullptr, TYPE_STRING, TYPE_VOID, false);
+    const Field* fields[] = {&f1, &f2};
+
+    auto describe = [&](const char* s1, const char* s2) {
+        Value v1(TYPE_STRING);
+        v1.val.string_val.data = const_cast<char*>(s1);
+        v1.val.string_val.length = strlen(s1);
+        v1.borrowed = true;
+        Value v2(TYPE_STRING);
+        v2.val.string_val.data = const_cast<char*>(s2);
+        v2.val.string_val.length = strlen(s2);
+        v2.borrowed = true;
+        Value* vals[] = {&v1, &v2};
+
+        ODesc desc;
+        json.Describe(&desc, 2, fields, vals);
+        return std::string(desc.Description());
+    };
+
+    CHECK(describe("plain text, longer than 8", "x") == R"({"a\"b":"plain text, longer than 8","c":"x"})");
+    CHECK(describe("tab\there", "\x82 and \xc3\xb1") == R"({"a\"b":"tab\there","c":"\\x82 and \\xc3\\xb1"})");
+    CHECK(describe("quote\" and \\", "\x7f") == R"({"a\"b":"quote\" and \\","c":"\\x7f"})");
+}
+
+TEST_SUITE_END();
+
 } // namespace zeek::threading::formatter
@@ -13,8 +13,15 @@ class NullDoubleWriter;
 namespace zeek::threading::formatter {
 
 /**
- * A thread-safe class for converting values into a JSON representation
- * and vice versa.
+ * A class for converting values into a JSON representation and vice versa.
+ *
+ * An instance is not thread-safe: it must only be used by one thread at a
+ * time, normally the thread owning it. Describing records reuses an output
+ * buffer and caches the field names rendered as JSON keys. The key cache
+ * is keyed on the address and size of the \a fields array passed to
+ * Describe(), so a caller must not hand in different fields at an address
+ * it used before. Log writers keep one array for their schema, which
+ * satisfies that.
  */
 class JSON : public Formatter {
 public:
@@ -26,7 +33,7 @@ public:
     };
 
     JSON(MsgThread* t, TimeFormat tf, bool include_unset_fields = false);
-    ~JSON() override = default;
+    ~JSON() override;
 
     bool Describe(ODesc* desc, Value* val, const std::string& name = "") const override;
     bool Describe(ODesc* desc, int num_fields, const Field* const* fields, Value** vals) const override;
@@ -34,10 +41,14 @@ public:
                       TypeTag subtype = TYPE_ERROR) const override;
 
 private:
+    struct State;
+
     void BuildJSON(zeek::json::detail::NullDoubleWriter& writer, Value* val, const std::string& name = "") const;
+    void BuildISO8601(zeek::json::detail::NullDoubleWriter& writer, double ts) const;
 
     TimeFormat timestamps;
     bool include_unset_fields;
+    std::unique_ptr<State> state;
 };
 
 } // namespace zeek::threading::formatter
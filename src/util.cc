@@ -40,6 +40,7 @@
 
 #include <algorithm>
 #include <array>
+#include <charconv>
 #include <iostream>
 #include <random>
 #include <string>
@@ -1041,6 +1042,102 @@ char* copy_string(const char* s) {
     return c;
 }
 
+size_t format_int(int64_t v, char* buf) {
+    auto end = std::to_chars(buf, buf + NUMBER_BUFFER_SIZE - 1, v).ptr;
+    *end = '\0';
+    return end - buf;
+}
+
+size_t format_uint(uint64_t v, char* buf) {
+    auto end = std::to_chars(buf, buf + NUMBER_BUFFER_SIZE - 1, v).ptr;
+    *end = '\0';
+    return end - buf;
+}
+
+size_t format_double(double d, int precision, char* buf) { return modp_dtoa(d, buf, precision); }
+
+size_t TimeFormatter::Format(double t, char* buf) {
+    // This follows modp_dtoa()'s rounding for the range where it doesn't
+    // switch to exponential notation. Negative times, halfway cases and a
+    // fraction rounding up into the next second take the regular path.
+    if ( ! (t >= 0.0 && t <= static_cast<double>(INT32_MAX)) )
+        return format_double(t, 6, buf);
+
+    auto secs = static_cast<int32_t>(t);
+    double scaled = (t - secs) * 1000000.0;
+    auto usecs = static_cast<uint32_t>(scaled);
+    double diff = scaled - usecs;
+
+    if ( diff == 0.5 || (diff > 0.5 && ++usecs == 1000000) )
+        return format_double(t, 6, buf);
+
+    if ( secs != last_secs ) {
+        secs_len = format_uint(secs, secs_digits);
+        last_secs = secs;
+    }
+
+    memcpy(buf, secs_digits, secs_len);
+    char* p = buf + secs_len;
+    *p++ = '.';
+
+    for ( int i = 5; i >= 0; i-- ) {
+        p[i] = '0' + usecs % 10;
+        usecs /= 10;
+    }
+
+    p[6] = '\0';
+    return secs_len + 7;
+}
+
+TEST_CASE("util format_int") {
+    char buf[NUMBER_BUFFER_SIZE];
+    char expected[NUMBER_BUFFER_SIZE];
+
+    for ( int64_t v : {int64_t(0), int64_t(7), int64_t(-7), int64_t(1234567890), INT64_MAX, INT64_MIN} ) {
+        snprintf(expected, sizeof(expected), "%" PRId64, v);
+        CHECK(format_int(v, buf) == strlen(expected));
+        CHECK(strcmp(buf, expected) == 0);
+    }
+
+    for ( uint64_t v : {uint64_t(0), uint64_t(80), uint64_t(4294967296), UINT64_MAX} ) {
+        snprintf(expected, sizeof(expected), "%" PRIu64, v);
+        CHECK(format_uint(v, buf) == strlen(expected));
+        CHECK(strcmp(buf, expected) == 0);
+    }
+}
+
+TEST_CASE("util format_double") {
+    char buf[NUMBER_BUFFER_SIZE];
+
+    CHECK(format_double(1300475167.096535, 6, buf) == 17);
+    CHECK(strcmp(buf, "1300475167.096535") == 0);
+    CHECK(format_double(0.5, 6, buf) == 8);
+    CHECK(strcmp(buf, "0.500000") == 0);
+    CHECK(format_double(-2.25, 6, buf) == 9);
+    CHECK(strcmp(buf, "-2.250000") == 0);
+}
+
+TEST_CASE("util TimeFormatter") {
+    TimeFormatter formatter;
+    char buf[NUMBER_BUFFER_SIZE];
+    char expected[NUMBER_BUFFER_SIZE];
+
+    for ( double base : {0.0, 1.0, 1300475167.0, 1700000000.999, 2147483646.5} ) {
+        for ( int i = 0; i < 10000; i++ ) {
+            double t = base + i * 0.0000973;
+            size_t len = format_double(t, 6, expected);
+            CHECK(formatter.Format(t, buf) == len);
+            CHECK(strcmp(buf, expected) == 0);
+        }
+    }
+
+    for ( double t : {-1.5, 0.9999995, 0.0000005, 2147483648.0, 1e20} ) {
+        size_t len = format_double(t, 6, expected);
+        CHECK(formatter.Format(t, buf) == len);
+        CHECK(strcmp(buf, expected) == 0);
+    }
+}
+
 TEST_CASE("util streq") {
     CHECK(streq("abcd", "abcd") == true);
     CHECK(streq("abcd", "efgh") == false);
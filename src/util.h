@@ -332,6 +332,80 @@ std::vector<std::string_view> tokenize_string(std::string_view input, const char
 
 extern char* copy_string(const char* str, size_t len);
 extern char* copy_string(const char* s);
+
+/**
+ * Size of a buffer large enough for the results of format_int(),
+ * format_uint() and format_double().
+ */
+constexpr size_t NUMBER_BUFFER_SIZE = 64;
+
+/**
+ * Renders an integer in decimal notation, without allocating.
+ *
+ * @param v The value.
+ *
+ * @param buf Receives the null-terminated result. Must have room for
+ * NUMBER_BUFFER_SIZE characters.
+ *
+ * @return The length of the result.
+ */
+extern size_t format_int(int64_t v, char* buf);
+
+/**
+ * Renders an unsigned integer in decimal notation, without allocating.
+ *
+ * @param v The value.
+ *
+ * @param buf Receives the null-terminated result. Must have room for
+ * NUMBER_BUFFER_SIZE characters.
+ *
+ * @return The length of the result.
+ */
+extern size_t format_uint(uint64_t v, char* buf);
+
+/**
+ * Renders a double with a fixed number of digits after the decimal point,
+ * keeping trailing zeros, without allocating. This is the representation
+ * logs use for times and intervals.
+ *
+ * @param d The value.
+ *
+ * @param precision The number of digits after the decimal point, up to 9.
+ *
+ * @param buf Receives the null-terminated result. Must have room for
+ * NUMBER_BUFFER_SIZE characters.
+ *
+ * @return The length of the result.
+ */
+extern size_t format_double(double d, int precision, char* buf);
+
+/**
+ * Renders times the way format_double() does with a precision of 6. An
+ * instance remembers the rendering of the whole seconds of the last time
+ * it saw. Timestamps of consecutive log records mostly fall into the same
+ * second, so usually only the fractional digits get rendered. An instance
+ * must only be used by one thread at a time.
+ */
+class TimeFormatter {
+public:
+    /**
+     * Renders a time, without allocating.
+     *
+     * @param t The time.
+     *
+     * @param buf Receives the null-terminated result. Must have room for
+     * NUMBER_BUFFER_SIZE characters.
+     *
+     * @return The length of the result.
+     */
+    size_t Format(double t, char* buf);
+
+private:
+    int64_t last_secs = -1;
+    char secs_digits[NUMBER_BUFFER_SIZE];
+    size_t secs_len = 0;
+};
+
 extern bool streq(const char* s1, const char* s2);
 extern bool starts_with(std::string_view s, std::string_view beginning);
 extern bool ends_with(std::string_view s, std::string_view ending);
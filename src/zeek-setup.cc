@@ -36,6 +36,7 @@
 #include "zeek/Frame.h"
 #include "zeek/Func.h"
 #include "zeek/Hash.h"
+#include "zeek/MemoryAccounting.h"
 #include "zeek/NetVar.h"
 #include "zeek/Options.h"
 #include "zeek/Reporter.h"
@@ -805,7 +806,12 @@ SetupResult setup(int argc, char** argv, Options* zopts) {
 
         RecordType::InitPostScript();
 
+        // A supervised node in zygote mode forks its zygote here: the scripts
+        // are loaded, but no threads have been started yet.
+        Supervisor::StartZygote();
+
         telemetry_mgr->InitPostScript();
+        init_memory_accounting_metrics();
         thread_mgr->InitPostScript();
         iosource_mgr->InitPostScript();
         log_mgr->InitPostScript();